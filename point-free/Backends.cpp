@@ -0,0 +1,162 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#include "Backends.h"
+#include "BulkAbstraction.h"
+
+#include <cassert>
+#include <memory>
+
+namespace {
+
+// The names mp11.hpp and alias.hpp define, besides the routes.
+static const char* const PreludeHeaderNames[] = { "id", "const_", "S", "fix", "compose", "dollar", "flip" };
+
+static bool DefinedByPreludeHeaders(const std::string& name) {
+	for (const char* defined : PreludeHeaderNames) {
+		if (name == defined)
+			return true;
+	}
+	std::string routes;
+	return isARouteCombinator(name, routes);
+}
+
+class Curtains : public Backend {
+public:
+	std::string Name() const override { return "curtains"; }
+	std::string Prelude() const override { return ""; }
+
+	std::string Apply(const std::string& f, const std::string& arg) const override {
+		return "eval<" + f + "," + arg + ">";
+	}
+
+	std::string Quote(const std::string& name) const override { return "quote<" + name + ">"; }
+	std::string QuoteTrait(const std::string& name) const override { return "quote_c<" + name + ">"; }
+
+	// Curtains has no routing combinators, they are written with the
+	// binary ones, see BulkAbstraction.h.
+	std::string Combinator(const std::string& name) const override {
+		std::unique_ptr<CExpr> expanded(ExpandRouteCombinator(name));
+		if (expanded)
+			return ConvertToBackend(expanded.get(), *this);
+		return name;
+	}
+};
+
+class Mp11 : public Backend {
+public:
+	std::string Name() const override { return "mp11"; }
+	std::string Prelude() const override { return "#include \"pointfree/mp11.hpp\"\nusing namespace pointfree::mp11;\n"; }
+
+	std::string Apply(const std::string& f, const std::string& arg) const override {
+		return "mp_invoke_q<" + f + "," + arg + ">";
+	}
+
+	std::string Quote(const std::string& name) const override { return "quote<" + name + ">"; }
+	std::string QuoteTrait(const std::string& name) const override { return "quote_trait<" + name + ">"; }
+
+	bool Defines(const std::string& name) const override { return DefinedByPreludeHeaders(name); }
+};
+
+class Alias : public Backend {
+public:
+	std::string Name() const override { return "alias"; }
+	std::string Prelude() const override { return "#include \"pointfree/alias.hpp\"\nusing namespace pointfree::alias;\n"; }
+
+	std::string Apply(const std::string& f, const std::string& arg) const override {
+		return "apply<" + f + "," + arg + ">";
+	}
+
+	std::string Quote(const std::string& name) const override { return "quote<" + name + ">"; }
+	std::string QuoteTrait(const std::string& name) const override { return "quote_trait<" + name + ">"; }
+
+	bool Defines(const std::string& name) const override { return DefinedByPreludeHeaders(name); }
+};
+
+const Curtains CurtainsInstance;
+const Mp11 Mp11Instance;
+const Alias AliasInstance;
+
+const Backend* const Backends[] = { &CurtainsInstance, &Mp11Instance, &AliasInstance };
+
+} // namespace
+
+const Backend* FindBackend(const std::string& name) {
+	for (const Backend* backend : Backends) {
+		if (backend->Name() == name)
+			return backend;
+	}
+	return nullptr;
+}
+
+std::vector<std::string> BackendNames() {
+	std::vector<std::string> names;
+	for (const Backend* backend : Backends)
+		names.push_back(backend->Name());
+	return names;
+}
+
+const Backend& CurtainsBackend() {
+	return CurtainsInstance;
+}
+
+std::string ConvertToBackend(CExpr* expr, const Backend& backend) {
+	std::string ret = "";
+
+	if (expr == nullptr)
+		ret += "nullptr error";
+
+	if (Var* var = dynamic_cast<Var*>(expr)) {
+		if (var->curtainsWrapper == "alias") { // a shared subterm, see CommonSubterms.h
+			ret += var->name;
+		} else if (isFromTypeTraits(var->name)) {
+			std::size_t found = var->name.find_last_of("::");
+
+			if (found != std::string::npos) {
+				if (var->name.substr(found+1) == "t") // ::t
+					ret += backend.QuoteTrait("std::" + var->name.substr(0, found - 1));
+				else if (var->name.substr(found+1) == "v") // ::v
+					ret += "unhandled value \n";
+
+			} else {
+				ret += backend.Quote("std::" + var->name);
+			}
+
+		} else if (isAPrimitiveType(var->name)) { // is an int, float etc.
+			ret += var->name;
+		} else if (isACombinatorOrPrelude(var->name)) {
+			ret += backend.Combinator(var->name);
+		} else if (var->curtainsWrapper == "quote_c") {
+			ret += backend.QuoteTrait(var->name);
+		} else {
+			ret += backend.Quote(var->name);
+		}
+	}
+
+	if (App* app = dynamic_cast<App*>(expr)) {
+		ret += backend.Apply(ConvertToBackend(app->exprL, backend), ConvertToBackend(app->exprR, backend));
+	}
+
+	if (dynamic_cast<CLambda*>(expr)) {
+		assert(false);
+	}
+
+	return ret;
+}
+
+std::string FindUndefinedCombinator(CExpr* expr, const Backend& backend) {
+	if (Var* var = dynamic_cast<Var*>(expr)) {
+		if (var->curtainsWrapper != "alias" && !isFromTypeTraits(var->name) && !isAPrimitiveType(var->name)
+		 && isACombinatorOrPrelude(var->name) && !backend.Defines(var->name))
+			return var->name;
+	}
+
+	if (App* app = dynamic_cast<App*>(expr)) {
+		std::string name = FindUndefinedCombinator(app->exprL, backend);
+		return name.empty() ? FindUndefinedCombinator(app->exprR, backend) : name;
+	}
+
+	return "";
+}
+
+std::string UndefinedCombinatorError(const std::string& name, const Backend& backend) {
+	return "the result uses " + name + ", which the " + backend.Name() + " backend does not define";
+}
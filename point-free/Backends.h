@@ -0,0 +1,77 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#pragma once
+#include "Common.h"
+
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////
+/* Output Backends 													  */
+////////////////////////////////////////////////////////////////////////
+
+// A point-free result is only a tree of applications of combinators and
+// quoted metafunctions, a Backend decides how each of those is spelled in
+// C++. The available backends are:
+//
+//   curtains  eval<eval<compose,quote<f>>,quote_c<std::remove_cv>>
+//   mp11      mp_invoke_q<mp_invoke_q<compose,quote<f>>,quote_trait<std::remove_cv>>
+//   alias     apply<apply<compose,quote<f>>,quote_trait<std::remove_cv>>
+//
+// Curtains' eval curries by itself, which makes it comparatively expensive
+// to instantiate. The other two apply metafunction classes to one argument
+// at a time through a plain fn member alias, the combinators and a curried
+// quote for them come from the headers in include/pointfree, mp11.hpp
+// (built on Boost.Mp11) and alias.hpp (standard C++17 only). Both define
+// their names in a namespace of their own, pointfree::mp11 and
+// pointfree::alias, which the code using the output brings in with a
+// using-directive (generated headers have one of their own).
+class Backend {
+public:
+	virtual ~Backend() {}
+
+	// The name selecting the backend, as given to -backend=.
+	virtual std::string Name() const = 0;
+
+	// The lines a generated header starts with to include the library and
+	// bring its names in, or "" when the user is expected to do so.
+	virtual std::string Prelude() const = 0;
+
+	// f applied to a single argument.
+	virtual std::string Apply(const std::string& f, const std::string& arg) const = 0;
+
+	// A template taking types used as a metafunction class, its result is the
+	// instantiation itself (an alias template such as std::add_pointer_t) or
+	// the instantiation's type member (a trait such as std::add_pointer).
+	virtual std::string Quote(const std::string& name) const = 0;
+	virtual std::string QuoteTrait(const std::string& name) const = 0;
+
+	// One of the combinators the algorithm produces, including the routes
+	// of -bulk (see BulkAbstraction.h), or another name from Curtains'
+	// prelude the input referred to.
+	virtual std::string Combinator(const std::string& name) const { return name; }
+
+	// Whether the backend's library defines the combinator or prelude name.
+	// Curtains defines them all, mp11.hpp and alias.hpp only the ones the
+	// algorithm produces, not the rest of Curtains' prelude (cons, foldr,
+	// map and so on).
+	virtual bool Defines(const std::string& name) const { return true; }
+};
+
+// Returns the backend called name, or nullptr if there is none.
+const Backend* FindBackend(const std::string& name);
+
+// The names FindBackend accepts, for option help and diagnostics.
+std::vector<std::string> BackendNames();
+
+// The backend used when none is chosen.
+const Backend& CurtainsBackend();
+
+// The spelling of a point-free expression in backend's syntax.
+std::string ConvertToBackend(CExpr* expr, const Backend& backend);
+
+// The first combinator or prelude name in expr that backend doesn't define,
+// "" when there is none.
+std::string FindUndefinedCombinator(CExpr* expr, const Backend& backend);
+
+// The diagnostic for a result referring to name, which backend doesn't define.
+std::string UndefinedCombinatorError(const std::string& name, const Backend& backend);
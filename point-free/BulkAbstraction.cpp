@@ -0,0 +1,217 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#include "BulkAbstraction.h"
+#include "ConversionBudget.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+// The binary combinator routing a single variable.
+static const char* RouteOfOne(char route) {
+	switch (route) {
+	case 'f': return "flip";
+	case 'g': return "compose";
+	default: return "S";
+	}
+}
+
+static CExpr* Route(const std::string& routes) {
+	if (routes.size() == 1)
+		return new Var(RouteOfOne(routes[0]));
+	return new Var(RouteCombinatorName(routes));
+}
+
+static CExpr* Apply(CExpr* f, CExpr* x, CExpr* y) {
+	return new App(new App(f, x), y);
+}
+
+static bool IsId(CExpr* expr) {
+	Var* var = dynamic_cast<Var*>(expr);
+	return var && var->name == "id";
+}
+
+// Whether every lambda in expr binds a single variable, which is all the
+// bulk compiler handles.
+static bool OnlyVariablePatterns(CExpr* expr) {
+	if (App* app = dynamic_cast<App*>(expr))
+		return OnlyVariablePatterns(app->exprL) && OnlyVariablePatterns(app->exprR);
+	if (CLambda* lambda = dynamic_cast<CLambda*>(expr))
+		return dynamic_cast<PVar*>(lambda->pat) && OnlyVariablePatterns(lambda->expr);
+	return true;
+}
+
+// A subterm is d applied to the variables it uses, given by how deep their
+// lambdas are, outermost first. A d of nullptr is a subterm that could not
+// be compiled.
+struct Compiled {
+	std::vector<unsigned> vars;
+	CExpr* d;
+};
+
+class BulkCompiler {
+public:
+	explicit BulkCompiler(ConversionBudget* budget) : budget(budget) {}
+
+	Compiled Compile(CExpr* expr) {
+		// an overspent conversion is abandoned, expr is returned as it is
+		if (budget && budget->Limit() != BudgetLimit::None)
+			return Compiled{{}, expr};
+
+		if (Var* var = dynamic_cast<Var*>(expr)) {
+			for (std::size_t depth = env.size(); depth-- > 0;) {
+				if (env[depth] == var->name) {
+					delete var;
+					Spend(1);
+					return Compiled{{unsigned(depth)}, new Var("id")};
+				}
+			}
+			return Compiled{{}, var};
+		}
+
+		if (App* app = dynamic_cast<App*>(expr)) {
+			Compiled f = Compile(app->exprL);
+			app->exprL = nullptr;
+			if (f.d == nullptr) {
+				delete app;
+				return f;
+			}
+
+			Compiled x = Compile(app->exprR);
+			app->exprR = nullptr;
+			delete app;
+			if (x.d == nullptr) {
+				delete f.d;
+				return x;
+			}
+
+			return Join(f, x);
+		}
+
+		if (CLambda* lambda = dynamic_cast<CLambda*>(expr)) {
+			PVar* pVar = dynamic_cast<PVar*>(lambda->pat);
+			if (pVar == nullptr) {
+				delete lambda;
+				return Compiled{{}, nullptr};
+			}
+
+			env.push_back(pVar->name);
+			Compiled body = Compile(lambda->expr);
+			lambda->expr = nullptr;
+			delete lambda;
+			env.pop_back();
+
+			if (body.d == nullptr)
+				return body;
+
+			// the variable is the innermost, so the last the body takes,
+			// and the lambda is the body by eta reduction
+			if (!body.vars.empty() && body.vars.back() == env.size()) {
+				body.vars.pop_back();
+				return body;
+			}
+
+			// the body doesn't use the variable, the lambda is const_ of it
+			Spend(3);
+			if (body.vars.empty())
+				return Compiled{{}, new App(new Var("const_"), body.d)};
+			if (body.vars.size() == 1 && IsId(body.d)) {
+				delete body.d;
+				return Compiled{body.vars, new Var("const_")};
+			}
+
+			std::string routes(body.vars.size(), 'g');
+			return Compiled{body.vars, Apply(Route(routes), new Var("const_"), body.d)};
+		}
+
+		delete expr;
+		return Compiled{{}, nullptr};
+	}
+
+private:
+	// f x, from the two halves compiled.
+	Compiled Join(Compiled& f, Compiled& x) {
+		if (f.vars.empty() && x.vars.empty()) {
+			Spend(1);
+			return Compiled{{}, new App(f.d, x.d)};
+		}
+
+		// f applied to a variable bound inside all of f's is f
+		if (x.vars.size() == 1 && IsId(x.d) && (f.vars.empty() || f.vars.back() < x.vars[0])) {
+			delete x.d;
+			f.vars.push_back(x.vars[0]);
+			return f;
+		}
+
+		// merge the variables, noting where each one goes
+		std::vector<unsigned> vars;
+		std::string routes;
+		std::size_t i = 0, j = 0;
+		while (i < f.vars.size() || j < x.vars.size()) {
+			if (j == x.vars.size() || (i < f.vars.size() && f.vars[i] < x.vars[j])) {
+				vars.push_back(f.vars[i++]);
+				routes += 'f';
+			} else if (i == f.vars.size() || x.vars[j] < f.vars[i]) {
+				vars.push_back(x.vars[j++]);
+				routes += 'g';
+			} else {
+				vars.push_back(f.vars[i++]);
+				++j;
+				routes += 'b';
+			}
+		}
+
+		Spend(3);
+		return Compiled{vars, Apply(Route(routes), f.d, x.d)};
+	}
+
+	void Spend(unsigned nodes) {
+		if (budget)
+			budget->Spend(nodes, (sizeof(App) + sizeof(Var)) / 2);
+	}
+
+	// The names bound by the lambdas around the subterm, innermost last.
+	std::vector<std::string> env;
+	ConversionBudget* budget;
+};
+
+// With R the route of the rest of the variables:
+//
+//   route<to::f,...>  = compose flip (compose R)
+//   route<to::g,...>  = compose compose R
+//   route<to::fg,...> = compose S (compose R)
+static CExpr* Expand(const std::string& routes) {
+	if (routes.size() == 1)
+		return new Var(RouteOfOne(routes[0]));
+
+	CExpr* rest = Expand(routes.substr(1));
+	if (routes[0] == 'g')
+		return Apply(new Var("compose"), new Var("compose"), rest);
+	return Apply(new Var("compose"), new Var(RouteOfOne(routes[0])), new App(new Var("compose"), rest));
+}
+
+} // namespace
+
+CExpr* PointFreeBulk(CExpr* expr, ConversionBudget* budget) {
+	if (expr == nullptr)
+		return nullptr;
+
+	// anything else is left to PointFree, as it would be without -bulk
+	if (!OnlyVariablePatterns(expr))
+		return PointFree(expr, nullptr, nullptr, budget);
+
+	// '*' is rewritten as Transform does, no names are made so the bound
+	// ones are left as they are
+	ConvertNonTypesToMetafunctions(expr);
+	Shuffle(expr);
+
+	BulkCompiler compiler(budget);
+	return compiler.Compile(expr).d;
+}
+
+CExpr* ExpandRouteCombinator(const std::string& name) {
+	std::string routes;
+	if (!isARouteCombinator(name, routes))
+		return nullptr;
+	return Expand(routes);
+}
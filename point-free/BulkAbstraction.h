@@ -0,0 +1,41 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#pragma once
+#include "Common.h"
+
+#include <string>
+
+////////////////////////////////////////////////////////////////////////
+/* Bulk Abstraction 												  */
+////////////////////////////////////////////////////////////////////////
+
+// PointFree removes the binders of a metafunction's lambdas one at a time,
+// so a variable used deep inside a body of N lambdas is routed past the
+// other N - 1 by a combinator for each of them, and the result can grow
+// with the square of N or worse. The bulk engine removes every binder in
+// the same traversal instead. Each subterm is compiled to a term taking the
+// variables it uses, in the order they are bound, so an application is
+// joined by a single routing combinator passing each variable to the
+// function, the argument or both:
+//
+//   route<to::f,to::g,to::fg> f g x y z = f x z (g y z)
+//
+// A route of one variable is flip, compose or S, which are written instead.
+// The result has a number of nodes linear in the input's, but a route's
+// name lists every variable it passes, so the text written can grow with
+// the square of the number of variables: a body using N of them in
+// reverse order takes about 200KB with the alias backend at N = 256.
+// mp11.hpp and alias.hpp define route, Curtains has nothing like it, so for
+// Curtains a route is spelled with the binary combinators (see
+// ExpandRouteCombinator), several times longer again.
+
+// The bulk abstraction counterpart of PointFree. The expression is
+// consumed, the result is owned by the caller, nullptr if expr could not be
+// converted. A term with a lambda binding anything but a variable is
+// converted by PointFree instead. With a budget, the nodes made are spent
+// from it as in PointFree.
+CExpr* PointFreeBulk(CExpr* expr, ConversionBudget* budget = nullptr);
+
+// The routing combinator name (see isARouteCombinator) written with
+// compose, flip and S alone, owned by the caller, nullptr if name is not
+// one. The expansion grows with the number of variables routed.
+CExpr* ExpandRouteCombinator(const std::string& name);
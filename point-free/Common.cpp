@@ -0,0 +1,831 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#include "Common.h"
+#include "Backends.h"
+#include "ConversionBudget.h"
+#include "ConversionMemo.h"
+#include "TaskPool.h"
+
+#include <map>
+#include <stack>
+#include <iostream>
+#include <cassert>
+
+////////////////////////////////////////////////////////////////////////
+/* Helpers 								  							  */
+////////////////////////////////////////////////////////////////////////
+
+void Print(Pattern* p) {
+	if (p == nullptr)
+		std::cout << "nullptr error \n";
+
+	if (PVar* pVar = dynamic_cast<PVar*>(p)) {
+		std::cout << " (PVar " << pVar->name << ")";
+	}
+}
+	
+void Print(CExpr* expr) {
+	if (expr == nullptr)
+		std::cout << "nullptr error \n";
+	
+	if (Var* var = dynamic_cast<Var*>(expr)) {				 
+		std::cout << " (Var " << var->name << ")";
+	}
+	
+	if (App* app = dynamic_cast<App*>(expr)) {
+		std::cout << " (App ";
+		Print(app->exprL);
+		Print(app->exprR);
+		std::cout << ")";
+	}
+
+	if (CLambda* lambda = dynamic_cast<CLambda*>(expr)) {
+		std::cout << " (Lambda ";
+		Print(lambda->pat);
+		Print(lambda->expr);
+		std::cout << ")";
+	}
+}	
+
+Pattern* Clone(Pattern* p) {
+	if (PVar* pVar = dynamic_cast<PVar*>(p))
+		return new PVar(pVar->name);
+
+	return nullptr;
+}
+
+CExpr* Clone(CExpr* expr) {
+	CExpr* ret = nullptr;
+
+	if (Var* var = dynamic_cast<Var*>(expr))
+		ret = new Var(var->name);
+
+	if (App* app = dynamic_cast<App*>(expr))
+		ret = new App(Clone(app->exprL), Clone(app->exprR));
+
+	if (CLambda* lambda = dynamic_cast<CLambda*>(expr))
+		ret = new CLambda(Clone(lambda->pat), Clone(lambda->expr));
+
+	if (ret != nullptr)
+		ret->curtainsWrapper = expr->curtainsWrapper;
+
+	return ret;
+}
+
+unsigned CountNodes(CExpr* expr) {
+	if (App* app = dynamic_cast<App*>(expr))
+		return 1 + CountNodes(app->exprL) + CountNodes(app->exprR);
+
+	if (CLambda* lambda = dynamic_cast<CLambda*>(expr))
+		return 1 + CountNodes(lambda->expr);
+
+	return expr ? 1 : 0;
+}
+
+void ConvertNonTypesToMetafunctions(CExpr* expr) {
+	if (Var* var = dynamic_cast<Var*>(expr)) {
+		if (var->name == "*")
+			var->name = "add_pointer_t";
+	}
+
+	if (App* app = dynamic_cast<App*>(expr)) {
+		ConvertNonTypesToMetafunctions(app->exprL);
+		ConvertNonTypesToMetafunctions(app->exprR);
+	}
+
+	if (CLambda* lambda = dynamic_cast<CLambda*>(expr)) {
+		ConvertNonTypesToMetafunctions(lambda->expr);
+				
+		// not sure if I want to swap these to meta-functions 
+		// if (PVar* pVar = dynamic_cast<PVar*>(lambda->pat)) {/*pVar->name*/}
+	}
+}
+
+
+void Shuffle(CExpr* expr) {
+	// if (Var* var = dynamic_cast<Var*>(expr)) {}
+
+	if (App* app = dynamic_cast<App*>(expr)) {
+		if (Var* var = dynamic_cast<Var*>(app->exprR)) {
+			if(var->name == "add_pointer_t") {
+				app->exprR = app->exprL;
+				app->exprL = var; 
+			}	
+		} 
+			
+		Shuffle(app->exprL);
+		Shuffle(app->exprR);
+	}
+
+	if (CLambda* lambda = dynamic_cast<CLambda*>(expr)) {
+		Shuffle(lambda->expr);
+	}
+		
+}
+
+// Test with the ones we currently use before commiting to this.
+// I might have to add _t and _v variants. Plain arrays of string literals,
+// unlike vectors of strings, need no code to run at startup.
+static const char* const TypeTraits[] = {"integral_constant",
+									   "bool_constant",
+									   "true_type",
+									   "false_type",
+									   "is_void",
+									   "is_null_pointer",
+									   "is_integral",
+									   "is_floating_point",
+									   "is_array",
+									   "is_pointer",
+									   "is_lvalue_reference",
+									   "is_rvalue_reference",
+									   "is_member_object_pointer",
+									   "is_member_function_pointer",
+									   "is_enum",
+									   "is_union",
+									   "is_class",
+									   "is_function",
+									   "is_reference",
+									   "is_arithmetic",
+									   "is_fundamental",
+									   "is_object",
+									   "is_scalar",
+									   "is_compound",
+									   "is_member_pointer",
+									   "is_const",
+									   "is_volatile",
+									   "is_trivial",
+									   "is_trivially_copyable",
+									   "is_standard_layout",
+									   "is_pod",
+									   "is_empty",
+									   "is_polymorphic",
+									   "is_abstract",
+									   "is_final",
+									   "is_aggregate",
+									   "is_signed",
+									   "is_unsigned",
+									   "is_constructible",
+									   "is_default_constructible",
+									   "is_copy_constructible",
+									   "is_move_constructible",
+									   "is_assignable",
+									   "is_copy_assignable",
+									   "is_move_assignable",
+									   "is_swappable_with",
+									   "is_swappable",
+									   "is_destructible",	
+									   "is_trivially_constructible",
+									   "is_trivially_default_constructible",
+									   "is_trivially_copy_constructible",
+									   "is_trivially_move_constructible",
+									   "is_trivially_assignable",
+									   "is_trivially_copy_assignable",
+									   "is_trivially_move_assignable",
+									   "is_trivially_destructible",							 
+									   "is_nothrow_constructible",
+									   "is_nothrow_default_constructible",
+									   "is_nothrow_copy_constructible",
+									   "is_nothrow_move_assignable",
+									   "is_nothrow_swappable_with",
+									   "is_nothrow_swappable",
+									   "is_nothrow_destructible",
+									   "has_virtual_destructor",
+									   "has_unique_object_representations",
+									   "alignment_of",
+									   "rank",
+									   "extent",
+									   "is_same",
+									   "is_base_of",
+									   "is_convertible",
+									   "is_invocable",
+									   "is_invocable_r",
+									   "is_nothrow_invocable",
+									   "is_nothrow_invocable_r",
+									   "remove_const",
+									   "remove_volatile",
+									   "remove_cv",
+									   "add_const",
+									   "add_volatile",
+									   "add_cv",
+									   "remove_const_t",
+									   "remove_volatile_t",
+									   "remove_cv_t",
+									   "add_const_t",
+									   "add_volatile_t",
+									   "add_cv_t",
+									   "remove_reference",
+									   "add_lvalue_reference",
+									   "add_rvalue_reference",
+									   "remove_reference_t",
+									   "add_lvalue_reference_t",
+									   "add_rvalue_reference_t",  
+									   "make_signed",
+									   "make_unsigned",
+									   "make_signed_t",									   
+									   "make_signed",
+									   "make_unsigned_t",
+									   "remove_extent",
+									   "remove_all_extents",
+									   "remove_extent_t",
+									   "remove_all_extents_t",
+									   "remove_pointer",
+									   "add_pointer",
+									   "remove_pointer_t",
+									   "add_pointer_t",
+									   "aligned_storage",
+									   "aligned_union",
+									   "decay",
+									   "remove_cvref",
+									   "enable_if",
+									   "conditional",
+									   "common_type",
+									   "underlying_type",
+									   "result_of",
+									   "result_of<F(ArgTypes...)>",
+									   "invoke_result",
+									   "aligned_storage_t",
+									   "aligned_union_t",
+									   "decay_t",
+									   "remove_cvref_t",
+									   "enable_if_t", 
+									   "conditional_t",
+									   "common_type_t",
+									   "underlying_type_t",
+									   "result_of_t",
+									   "invoke_result_t",
+									   "void_t",
+									   "conjunction",
+									   "disjunction",
+									   "negation",
+									   "is_void_v",
+									   "is_null_pointer_v",
+									   "is_integral_v",
+									   "is_floating_point_v",
+									   "is_array_v",
+									   "is_pointer_v",
+									   "is_lvalue_reference_v",
+									   "is_rvalue_reference_v",
+									   "is_member_object_pointer_v",
+									   "is_member_function_pointer_v",
+									   "is_enum_v",
+									   "is_union_v",
+									   "is_class_v",
+									   "is_function_v",
+									   "is_reference_v",
+									   "is_arithmetic_v",
+									   "is_fundamental_v",
+									   "is_object_v",
+									   "is_scalar_v",
+									   "is_compound_v",
+									   "is_member_pointer_v",
+									   "is_const_v",
+									   "is_volatile_v",
+									   "is_trivial_v",
+									   "is_trivially_copyable_v",
+									   "is_standard_layout_v",
+									   "is_pod_v",
+									   "is_empty_v",					   
+									   "is_polymorphic_v",
+									   "is_abstract_v",				
+									   "is_final_v",
+									   "is_aggregate_v",
+									   "is_signed_v",
+									   "is_unsigned_v",
+									   "is_constructible_v",
+									   "is_default_constructible_v",
+									   "is_copy_constructible_v",
+									   "is_move_constructible_v",
+									   "is_assignable_v",
+									   "is_copy_assignable_v",
+									   "is_move_assignable_v",
+									   "is_swappable_with_v",
+									   "is_swappable_v",
+									   "is_destructible_v",
+									   "is_trivially_constructible_v",
+									   "is_trivially_default_constructible_v",
+									   "is_trivially_copy_constructible_v",
+									   "is_trivially_move_constructible_v",
+									   "is_trivially_assignable_v",
+									   "is_trivially_copy_assignable_v",
+									   "is_trivially_move_assignable_v",
+									   "is_trivially_destructible_v",
+									   "is_nothrow_constructible_v",
+									   "is_nothrow_default_constructible_v",
+									   "is_nothrow_copy_constructible_v",
+									   "is_nothrow_move_constructible_v",
+									   "is_nothrow_assignable_v",
+									   "is_nothrow_copy_assignable_v",
+									   "is_nothrow_move_assignable_v",
+									   "is_nothrow_swappable_with_v",
+									   "is_nothrow_swappable_v",
+									   "is_nothrow_destructible_v",
+									   "has_virtual_destructor_v",
+									   "has_unique_object_representations_v",
+									   "alignment_of_v",
+									   "rank_v",
+									   "extent_v",
+									   "is_same_v",
+									   "is_base_of_v",
+									   "is_convertible_v",
+									   "is_invocable_v",
+									   "is_invocable_r_v",
+									   "is_nothrow_invocable_v",
+									   "is_nothrow_invocable_r_v",
+									   "conjunction_v",
+									   "disjunction_v",
+									   "negation_v"	   									   									   
+									   };
+ 
+ static const char* const PrimitiveTypes[] =   {"short",
+											  "short int",
+											  "signed short",
+											  "signed short int",
+											  "unsigned short",
+											  "unsigned short int",
+											  "int",
+											  "signed",
+											  "signed int",
+											  "unsigned",
+											  "unsigned int",
+											  "long",
+											  "long long", 
+											  "long int",
+											  "signed long",
+											  "signed long int",
+											  "unsigned long",
+											  "unsigned long int",
+											  "long long",
+											  "long long int",
+											  "signed long long",
+											  "signed long long int",
+											  "unsigned long long",
+											  "unsigned long long int",
+											  "float",
+											  "double",
+											  "long double",
+											  "char",
+											  "signed char",
+											  "unsigned char",
+											  "wchar_t",
+											  "char16_t",
+											  "char32_t",
+											  "string",
+											  "std::string",
+											  "void",
+											  "nullptr_t",
+											  "std::nullptr_t",
+											  "nullptr",
+											  "bool",
+											  "true",
+											  "false"
+											 };
+											 
+ static const char* const CombinatorOrPreludeNames[] = { "const_",
+													   "id",
+													   "S",
+													   "fix",
+													   "compose",
+													   "cons",
+													   "dollar",
+													   "flip",
+													   "foldl",
+													   "foldr",
+													   "get",
+													   "if_",
+													   "map",
+													   "fmap_tree"
+													 };
+											 
+
+// Create a Function is type traits that accepts a string, loops through
+// the array above and returns true. 
+bool isFromTypeTraits(std::string name) {
+	std::size_t found = name.find_last_of("::");
+	std::string modName = name.substr(0, found - 1);
+	for (const char* trait : TypeTraits) {
+		if (name == trait || modName == trait)
+			return true;
+	}
+	return false;
+}
+
+bool isAPrimitiveType(std::string name) {										
+	for (const char* primitive : PrimitiveTypes) {
+		if (name == primitive)
+			return true;
+	}
+	return false;
+}
+
+bool isACombinatorOrPrelude(std::string name) {										
+	for (const char* combinator : CombinatorOrPreludeNames) {
+		if (name == combinator)
+			return true;
+	}
+	std::string routes;
+	return isARouteCombinator(name, routes);
+}
+
+static const char* const RouteNames[] = { "to::f", "to::g", "to::fg" };
+static const char RouteCodes[] = { 'f', 'g', 'b' };
+
+bool isARouteCombinator(const std::string& name, std::string& routes) {
+	if (name.compare(0, 6, "route<") != 0 || name.back() != '>')
+		return false;
+
+	routes.clear();
+	std::size_t start = 6;
+	while (start < name.size()) {
+		std::size_t end = name.find_first_of(",>", start);
+		std::string route = name.substr(start, end - start);
+		std::size_t i = 0;
+		while (i < 3 && route != RouteNames[i])
+			++i;
+		if (i == 3)
+			return false;
+		routes += RouteCodes[i];
+		start = end + 1;
+	}
+	return !routes.empty();
+}
+
+std::string RouteCombinatorName(const std::string& routes) {
+	std::string name = "route<";
+	for (char route : routes) {
+		for (std::size_t i = 0; i < 3; ++i) {
+			if (route == RouteCodes[i])
+				name += std::string(name.size() > 6 ? "," : "") + RouteNames[i];
+		}
+	}
+	return name + ">";
+}
+
+
+
+////////////////////////////////////////////////////////////////////////
+/* Point-Free Algorithm 											  */
+////////////////////////////////////////////////////////////////////////
+
+static std::string MapSize(std::map<std::string, std::stack<std::string>> env) {
+	int size = 0;
+	
+	for (auto it = env.begin(); it != env.end(); ++it)
+		size += it->second.size();
+	
+	return std::to_string(size);
+}
+
+static std::string charGen(int index) {
+	std::string result;
+	while (index >= 0) {
+		result = (char)('a' + index % 26) + result;
+		index /= 26;
+		index--;
+	}
+	return result;
+}
+
+std::string fresh(std::vector<std::string> strList) {
+	unsigned int i = 0, genSeed = 0;
+	std::string cGen = charGen(genSeed);
+
+	while (i < strList.size())
+	{
+		if (strList[i] != cGen) {
+			++i;
+		} else {
+			++genSeed;
+			cGen = charGen(genSeed);
+			i = 0;
+		}
+	}
+		
+	return cGen;
+}
+
+static std::vector<std::string> AlphaPat(Pattern* pat, std::map<std::string, std::stack<std::string>>& env) {
+	
+	std::vector<std::string> nameList, tempList;
+
+	/*alphaPat(PVar v) = do
+	  fm <-get 
+	  let v' = "$" ++ show (M.size fm) 
+	  put $ M.insert v v' fm 
+	  return $ PVar v' */
+	if (PVar* pVar = dynamic_cast<PVar*>(pat)) {
+		std::string newName = "$" + MapSize(env);
+
+		// This has to be changed, we won't always be inserting a new element now.
+		// And the element is a stack.
+		auto it = env.find(pVar->name);
+		if (it != env.end()) {
+			it->second.push(newName);
+		} else {
+			std::stack<std::string> newStack; 
+			newStack.push(newName);
+			env.insert(std::pair<std::string, std::stack<std::string>>(pVar->name, newStack));
+		}
+		
+		nameList.push_back(pVar->name);
+		pVar->name = newName;
+	}
+	
+	return nameList;
+}
+
+static void Alpha(CExpr* expr, std::map<std::string, std::stack<std::string>>& env) {
+	// alpha(Var f v) = do fm <-get; return $ Var f $ maybe v id(M.lookup v fm)
+	if (Var* var = dynamic_cast<Var*>(expr)) {
+		auto it = env.find(var->name);
+		if (it != env.end())
+			var->name = it->second.top();
+	}
+
+	// alpha(App e1 e2) = liftM2 App(alpha e1) (alpha e2)
+	if (App* app = dynamic_cast<App*>(expr)) {
+		Alpha(app->exprL, env);
+		Alpha(app->exprR, env);
+	}
+
+	// alpha(Lambda v e') = inEnv $ liftM2 Lambda (alphaPat v) (alpha e')
+	if (CLambda* lambda = dynamic_cast<CLambda*>(expr)) {
+		std::vector<std::string> popList = AlphaPat(lambda->pat, env);
+		Alpha(lambda->expr, env);
+
+		for (size_t i = 0; i < popList.size(); ++i) {
+			auto it = env.find(popList[i]);
+			if (it != env.end()) {
+				it->second.pop();
+			}
+		}
+
+	}
+}
+
+void AlphaRename(CExpr* expr) {
+	// Key = Old name, Value = new $1 identifier 
+	std::map<std::string, std::stack<std::string>> env;
+	Alpha(expr, env);
+}
+
+void gatherNames(CExpr* expr, std::vector<std::string>& names) {
+	if (Var* var = dynamic_cast<Var*>(expr)) {
+		names.push_back(var->name);
+	}
+	
+	if (CLambda* lambda = dynamic_cast<CLambda*>(expr)) {
+		gatherNames(lambda->expr, names);
+	}
+
+	if (App* app = dynamic_cast<App*>(expr)) {
+		gatherNames(app->exprL, names);
+		gatherNames(app->exprR, names);
+	}	
+}
+
+bool occursInPattern(const std::string& name, Pattern* p) {
+	bool ret = false;
+
+	if (PVar* pVar = dynamic_cast<PVar*>(p)) {
+		ret = (pVar->name == name);
+	}
+
+	return ret;
+}
+
+int freeIn(const std::string& name, CExpr* expr) {
+	int ret = 0;
+
+	if (Var* var = dynamic_cast<Var*>(expr)) {
+		ret = (name == var->name);
+	}
+	
+	if (CLambda* lambda = dynamic_cast<CLambda*>(expr)) {
+		if (occursInPattern(name, lambda->pat))
+			ret = 0;
+		else
+			ret = freeIn(name, lambda->expr);
+	}
+
+	if (App* app = dynamic_cast<App*>(expr)) {
+		ret = freeIn(name, app->exprL) + freeIn(name, app->exprR);
+	}
+
+	return ret;
+}
+
+bool isFreeIn(const std::string& name, CExpr* expr) {
+	return (freeIn(name, expr) > 0);
+}
+
+// Whether the two halves of an App are worth handing to the pool, forking
+// costs far more than transforming a small subterm.
+static const unsigned ParallelCutoff = 512;
+
+static bool LargerThan(CExpr* expr, unsigned& budget) {
+	if (budget == 0)
+		return true;
+	--budget;
+
+	if (App* app = dynamic_cast<App*>(expr))
+		return LargerThan(app->exprL, budget) || LargerThan(app->exprR, budget);
+
+	if (CLambda* lambda = dynamic_cast<CLambda*>(expr))
+		return LargerThan(lambda->expr, budget);
+
+	return false;
+}
+
+static bool Parallel(TaskPool* pool, App* app) {
+	if (pool == nullptr)
+		return false;
+
+	unsigned budgetL = ParallelCutoff, budgetR = ParallelCutoff;
+	return LargerThan(app->exprL, budgetL) && LargerThan(app->exprR, budgetR);
+}
+
+// Each case of RemoveVariable that makes nodes adds an App and a Var to the
+// expression, counting the App it may free.
+static void Spend(ConversionBudget* budget, unsigned nodes = 2) {
+	if (budget)
+		budget->Spend(nodes, (sizeof(App) + sizeof(Var)) / 2);
+}
+
+// Without reading the clock, Spend does so now and then.
+static bool Overspent(ConversionBudget* budget) {
+	return budget && budget->Limit() != BudgetLimit::None;
+}
+
+CExpr* RemoveVariable(const std::string& name, const std::vector<std::string>& names, CExpr* expr,
+                      TaskPool* pool, ConversionMemo* memo, ConversionBudget* budget) {
+	// an overspent conversion is abandoned, expr is returned as it is
+	if (Overspent(budget))
+		return expr;
+
+	if (Var* var = dynamic_cast<Var*>(expr)) {
+		if (name == var->name) {
+			delete var;
+			return new Var("id");
+		} else {					
+			Spend(budget);
+			return new App(new Var("const_"), var);
+		}
+	}
+
+	if (CLambda* lambda = dynamic_cast<CLambda*>(expr)) {
+		if (!occursInPattern(name, lambda->pat)) {
+			return RemoveVariable(name, names, TransformRecursive(expr, names, pool, memo, budget), pool, memo, budget);
+		} else {
+			assert(false);
+		}
+		return expr; // should never actually occur
+	}
+
+	if (App* app = dynamic_cast<App*>(expr)) {
+		bool frL = isFreeIn(name, app->exprL);
+		bool frR = isFreeIn(name, app->exprR);
+		Var* vR = dynamic_cast<Var*>(app->exprR);
+		CExpr* temp;
+		
+		if (frL && frR) {
+			// the halves are disjoint, so they can be abstracted at once
+			if (Parallel(pool, app)) {
+				pool->Fork([&] { app->exprL = RemoveVariable(name, names, app->exprL, pool, memo, budget); },
+				           [&] { app->exprR = RemoveVariable(name, names, app->exprR, pool, memo, budget); });
+			} else {
+				app->exprL = RemoveVariable(name, names, app->exprL, pool, memo, budget);
+				app->exprR = RemoveVariable(name, names, app->exprR, pool, memo, budget);
+			}
+			Spend(budget);
+			temp = new App(new App(new Var("S"), app->exprL), app->exprR); // S combinator, instead of Haskell's ap monad 
+			app->exprL = nullptr; app->exprR = nullptr; delete app;
+			return temp;
+		} else if (frL) {
+			app->exprL = RemoveVariable(name, names, app->exprL, pool, memo, budget);
+			Spend(budget);
+			temp = new App(new App(new Var("flip"), app->exprL), app->exprR);
+			app->exprL = nullptr; app->exprR = nullptr; delete app;
+			return temp;
+		} else if (vR && vR->name == name) {
+			// can possibly delete exprR
+			return app->exprL;
+		} else if (frR) {
+			app->exprR = RemoveVariable(name, names, app->exprR, pool, memo, budget);
+			Spend(budget);
+			temp = new App(new App(new Var("compose"), app->exprL), app->exprR); // the compose metafunction instead of Haskell .
+			app->exprL = nullptr; app->exprR = nullptr; delete app;
+			return temp;
+		} else {
+			Spend(budget);
+			return new App(new Var("const_"), app); // the const_ metafunction instead of haskell const (const is also a reserved word in C++)
+		}
+	}
+	
+	return nullptr;
+}
+
+CExpr* TransformRecursive(CExpr* expr, const std::vector<std::string>& names, TaskPool* pool,
+                          ConversionMemo* memo, ConversionBudget* budget) {
+	if (Overspent(budget))
+		return expr;
+
+	if (Var* var = dynamic_cast<Var*>(expr)) {
+		return var;
+	}
+
+	if (App* app = dynamic_cast<App*>(expr)) {
+		if (Parallel(pool, app)) {
+			pool->Fork([&] { app->exprL = TransformRecursive(app->exprL, names, pool, memo, budget); },
+			           [&] { app->exprR = TransformRecursive(app->exprR, names, pool, memo, budget); });
+		} else {
+			app->exprL = TransformRecursive(app->exprL, names, pool, memo, budget);
+			app->exprR = TransformRecursive(app->exprR, names, pool, memo, budget);
+		}
+		return expr;
+	}
+
+	if (CLambda* lambda = dynamic_cast<CLambda*>(expr)) {
+		if (PVar* pVar = dynamic_cast<PVar*>(lambda->pat)) {
+			// kept, RemoveVariable takes the lambda apart
+			std::shared_ptr<const MemoShape> shape = memo ? lambda->shape : nullptr;
+			if (shape) {
+				if (CExpr* pf = memo->Find(*shape)) {
+					delete lambda;
+					if (budget)
+						Spend(budget, CountNodes(pf));
+					return pf;
+				}
+			}
+
+			CExpr* pf = TransformRecursive(RemoveVariable(pVar->name, names, lambda->expr, pool, memo, budget), names, pool, memo, budget);
+			if (shape && !Overspent(budget))
+				memo->Insert(*shape, pf);
+			return pf;
+		}
+	}
+	
+	return nullptr;
+}
+
+CExpr* Transform(CExpr* expr, TaskPool* pool, ConversionMemo* memo, ConversionBudget* budget) {
+	std::vector<std::string> nameList;
+	gatherNames(expr, nameList);
+	ConvertNonTypesToMetafunctions(expr);
+	Shuffle(expr);
+	if (memo)
+		memo->Prepare(expr);
+	return TransformRecursive(expr, nameList, pool, memo, budget);
+}
+
+CExpr* PointFree(CExpr* expr, TaskPool* pool, ConversionMemo* memo, ConversionBudget* budget) {
+	AlphaRename(expr);
+	return Transform(expr, pool, memo, budget);
+}
+
+
+////////////////////////////////////////////////////////////////////////
+/* Curtains Conversion 											  */
+////////////////////////////////////////////////////////////////////////
+
+CExpr* RemoveCurtainsFromCExpr(CExpr* expr) {
+	if (expr == nullptr)
+		return nullptr;
+		
+	//if (Var* var = dynamic_cast<Var*>(expr)) {}
+	
+	if (App* app = dynamic_cast<App*>(expr)) {
+		if (Var* exprL = dynamic_cast<Var*>(app->exprL)) {					
+			// remove quote/quote_c/eval				
+			if (exprL->name == "quote" || exprL->name == "quote_c" || exprL->name == "eval") {
+				// Unsure if this is enough, you can have quotes around Lambdas for instance  
+		 		if (Var* var = dynamic_cast<Var*>(app->exprR)) {
+					var->curtainsWrapper = exprL->name;	
+				}
+			
+				CExpr* temp = RemoveCurtainsFromCExpr(app->exprR);
+			
+				// delete parent node and left node, retain right node. 
+				app->exprR = nullptr; 
+				delete app;	
+				return temp;	
+			}
+		} else {
+			app->exprL = RemoveCurtainsFromCExpr(app->exprL); 
+			app->exprR = RemoveCurtainsFromCExpr(app->exprR);		
+		}
+	}
+
+	if (CLambda* lambda = dynamic_cast<CLambda*>(expr)) {
+		lambda->expr = RemoveCurtainsFromCExpr(lambda->expr);
+	}
+	
+	return expr;
+}
+
+// The Curtains spelling is one of the output backends, see Backends.h.
+std::string ConvertCExprToCurtains(CExpr* expr) {
+	return ConvertToBackend(expr, CurtainsBackend());
+}
+
+std::string ConvertToCurtains(CExpr* expr) {
+	return ConvertCExprToCurtains(expr);
+}
@@ -0,0 +1,193 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#include "CommonSubterms.h"
+
+#include <algorithm>
+#include <cstdio>
+
+// FNV-1a, used so that alias names don't depend on the platform
+static uint64_t HashBytes(uint64_t h, const void* data, std::size_t size) {
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (std::size_t i = 0; i < size; ++i) {
+		h ^= bytes[i];
+		h *= 1099511628211ull;
+	}
+	return h;
+}
+
+static uint64_t HashString(uint64_t h, const std::string& s) {
+	// include the terminator so "ab","c" and "a","bc" differ
+	return HashBytes(h, s.c_str(), s.size() + 1);
+}
+
+static uint64_t HashValue(uint64_t h, uint64_t v) {
+	unsigned char bytes[8];
+	for (int i = 0; i < 8; ++i)
+		bytes[i] = (unsigned char)(v >> (8 * i));
+	return HashBytes(h, bytes, 8);
+}
+
+unsigned SubtermTable::Intern(Node node) {
+	node.roots = 0;
+	nodes.push_back(node);
+	return nodes.size() - 1;
+}
+
+unsigned SubtermTable::Add(CExpr* expr) {
+	unsigned id = AddSubterm(expr);
+	++nodes[id].roots;
+	return id;
+}
+
+unsigned SubtermTable::AddSubterm(CExpr* expr) {
+	unsigned id;
+	const uint64_t basis = 14695981039346656037ull;
+
+	if (Var* var = dynamic_cast<Var*>(expr)) {
+		auto key = std::make_pair(var->name, var->curtainsWrapper);
+		auto it = vars.find(key);
+
+		if (it != vars.end()) {
+			id = it->second;
+		} else {
+			Node node;
+			node.kind = VarNode;
+			node.name = var->name;
+			node.curtainsWrapper = var->curtainsWrapper;
+			node.size = 1;
+			node.hash = HashString(HashString(HashString(basis, "V"), var->curtainsWrapper), var->name);
+			id = vars[key] = Intern(node);
+		}
+	} else if (App* app = dynamic_cast<App*>(expr)) {
+		unsigned left = AddSubterm(app->exprL), right = AddSubterm(app->exprR);
+
+		auto key = std::make_pair(left, right);
+		auto it = apps.find(key);
+
+		if (it != apps.end()) {
+			id = it->second;
+		} else {
+			Node node;
+			node.kind = AppNode;
+			node.left = left;
+			node.right = right;
+			node.size = 1 + nodes[left].size + nodes[right].size;
+			node.hash = HashValue(HashValue(HashString(basis, "A"), nodes[left].hash), nodes[right].hash);
+			id = apps[key] = Intern(node);
+		}
+	} else {
+		// nullptr, or a lambda the conversion failed to remove
+		if (nullId == ~0u) {
+			Node node;
+			node.kind = NullNode;
+			node.size = 1;
+			node.hash = HashString(basis, "N");
+			nullId = Intern(node);
+		}
+		id = nullId;
+	}
+
+	return id;
+}
+
+void SubtermTable::Share() {
+	// A node's children are interned before it, so walking the ids downwards
+	// sees every use of a node before the node itself. A shared node is
+	// written out once, in its definition, an unshared one at every use.
+	std::vector<unsigned> uses(nodes.size(), 0);
+
+	for (unsigned id = nodes.size(); id-- > 0;) {
+		Node& node = nodes[id];
+		uses[id] += node.roots;
+		node.alias = "";
+
+		if (uses[id] == 0)
+			continue;
+
+		unsigned written = uses[id];
+		if (uses[id] > 1 && node.size >= minSize) {
+			char name[32];
+			snprintf(name, sizeof(name), "pf_%016llx", (unsigned long long)node.hash);
+			node.alias = name;
+			written = 1;
+		}
+
+		if (node.kind == AppNode) {
+			uses[node.left] += written;
+			uses[node.right] += written;
+		}
+	}
+}
+
+CExpr* SubtermTable::Build(unsigned id) {
+	return Build(id, true);
+}
+
+CExpr* SubtermTable::Build(unsigned id, bool top) {
+	Node& node = nodes[id];
+
+	if (!top && !node.alias.empty()) {
+		Var* var = new Var(node.alias);
+		var->curtainsWrapper = "alias";
+		return var;
+	}
+
+	if (node.kind == VarNode) {
+		Var* var = new Var(node.name);
+		var->curtainsWrapper = node.curtainsWrapper;
+		return var;
+	}
+
+	if (node.kind == AppNode)
+		return new App(Build(node.left, false), Build(node.right, false));
+
+	return nullptr;
+}
+
+void SubtermTable::Reachable(unsigned id, std::vector<bool>& seen, std::vector<unsigned>& shared) {
+	if (seen[id])
+		return;
+	seen[id] = true;
+
+	if (!nodes[id].alias.empty())
+		shared.push_back(id);
+
+	if (nodes[id].kind == AppNode) {
+		Reachable(nodes[id].left, seen, shared);
+		Reachable(nodes[id].right, seen, shared);
+	}
+}
+
+std::string SubtermTable::WriteDefinitions(std::vector<unsigned> shared, const Backend& backend) {
+	// a subterm is larger than any subterm inside it, so ordering by size
+	// puts dependencies first, and the hash makes the order stable
+	std::sort(shared.begin(), shared.end(), [this](unsigned a, unsigned b) {
+		if (nodes[a].size != nodes[b].size)
+			return nodes[a].size < nodes[b].size;
+		return nodes[a].hash < nodes[b].hash;
+	});
+
+	std::string ret;
+	for (unsigned id : shared) {
+		CExpr* expr = Build(id, true);
+		ret += "using " + nodes[id].alias + " = " + ConvertToBackend(expr, backend) + ";\n";
+		delete expr;
+	}
+
+	return ret;
+}
+
+std::string SubtermTable::Definitions(unsigned root, const Backend& backend) {
+	std::vector<bool> seen(nodes.size(), false);
+	std::vector<unsigned> shared;
+	Reachable(root, seen, shared);
+	return WriteDefinitions(shared, backend);
+}
+
+std::string SubtermTable::Definitions(const Backend& backend) {
+	std::vector<unsigned> shared;
+	for (unsigned id = 0; id < nodes.size(); ++id) {
+		if (!nodes[id].alias.empty())
+			shared.push_back(id);
+	}
+	return WriteDefinitions(shared, backend);
+}
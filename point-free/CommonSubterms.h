@@ -0,0 +1,77 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#pragma once
+#include "Backends.h"
+#include "Common.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////
+/* Common Subterm Sharing 											  */
+////////////////////////////////////////////////////////////////////////
+
+// Point-free output tends to repeat itself, the same combinator subterm can
+// appear many times in one MFC. A SubtermTable interns every subterm of the
+// expressions added to it, so equal subterms share one entry, and picks the
+// ones used more than once to become type aliases:
+//
+//   using pf_5f0e9c3a1b2d4e68 = eval<compose,quote<f>>;
+//   eval<S,eval<pf_5f0e9c3a1b2d4e68,pf_5f0e9c3a1b2d4e68>>
+//
+// Alias names come from a hash of the subterm's content, so the same
+// subterm gets the same name in every run and in every converted class.
+class SubtermTable {
+public:
+	// Subterms smaller than minSize nodes are never shared, by default
+	// these are single names, which are no shorter than an alias.
+	explicit SubtermTable(unsigned minSize = 3) : minSize(minSize) {}
+
+	// Interns every subterm of a converted expression (Var and App nodes
+	// only), which is not modified, and returns the root's id.
+	unsigned Add(CExpr* expr);
+
+	// Picks the subterms to share, counting how often each would still be
+	// written out once its sharing parents are. Call after all Adds.
+	void Share();
+
+	// Rebuilds the subterm id, with the shared subterms below it replaced
+	// by Var nodes naming their aliases. The caller owns the result.
+	CExpr* Build(unsigned id);
+
+	// "using <alias> = <backend syntax>;" lines, one for each shared subterm
+	// reachable from root, dependencies first.
+	std::string Definitions(unsigned root, const Backend& backend = CurtainsBackend());
+
+	// As above for every shared subterm, in a stable order.
+	std::string Definitions(const Backend& backend = CurtainsBackend());
+
+	// The name of id's alias, or "" when it isn't shared.
+	const std::string& Alias(unsigned id) { return nodes[id].alias; }
+
+private:
+	enum Kind { VarNode, AppNode, NullNode };
+
+	struct Node {
+		Kind kind;
+		std::string name, curtainsWrapper; // VarNode
+		unsigned left, right;              // AppNode
+		unsigned size;
+		uint64_t hash;
+		unsigned roots;                    // times added as a root
+		std::string alias;
+	};
+
+	unsigned Intern(Node node);
+	unsigned AddSubterm(CExpr* expr);
+	CExpr* Build(unsigned id, bool top);
+	void Reachable(unsigned id, std::vector<bool>& seen, std::vector<unsigned>& shared);
+	std::string WriteDefinitions(std::vector<unsigned> shared, const Backend& backend);
+
+	unsigned minSize;
+	std::vector<Node> nodes;
+	std::map<std::pair<std::string, std::string>, unsigned> vars;
+	std::map<std::pair<unsigned, unsigned>, unsigned> apps;
+	unsigned nullId = ~0u;
+};
@@ -0,0 +1,53 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#include "ConversionBudget.h"
+
+std::string BudgetLimitName(BudgetLimit limit, const ConversionLimits& limits) {
+	switch (limit) {
+	case BudgetLimit::Nodes:
+		return "-max-nodes=" + std::to_string(limits.maxNodes);
+	case BudgetLimit::OutputBytes:
+		return "-max-output-bytes=" + std::to_string(limits.maxOutputBytes);
+	case BudgetLimit::Time:
+		return "-timeout-ms=" + std::to_string(limits.timeoutMs);
+	case BudgetLimit::None:
+		break;
+	}
+
+	return "";
+}
+
+bool ConversionBudget::Spend(uint64_t made, uint64_t bytesEach) {
+	uint64_t before = nodes.fetch_add(made);
+	bytes.fetch_add(made * bytesEach);
+
+	if (limits.maxNodes && before + made > limits.maxNodes)
+		Exceed(BudgetLimit::Nodes);
+
+	// the clock is only read when a multiple of ClockInterval is passed
+	if (limits.timeoutMs && before / ClockInterval != (before + made) / ClockInterval)
+		return !Exceeded();
+
+	return exceeded.load() == BudgetLimit::None;
+}
+
+bool ConversionBudget::Exceeded() {
+	if (exceeded.load() != BudgetLimit::None)
+		return true;
+
+	if (limits.timeoutMs) {
+		auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - start);
+		if (static_cast<uint64_t>(elapsed.count()) > limits.timeoutMs) {
+			Exceed(BudgetLimit::Time);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ConversionBudget::Exceed(BudgetLimit limit) {
+	// the first limit exceeded is the one reported
+	BudgetLimit none = BudgetLimit::None;
+	exceeded.compare_exchange_strong(none, limit);
+}
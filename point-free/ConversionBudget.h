@@ -0,0 +1,67 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+////////////////////////////////////////////////////////////////////////
+/* Conversion Budget 												  */
+////////////////////////////////////////////////////////////////////////
+
+// Limits on a single conversion, 0 for no limit. Bracket abstraction can
+// make the result grow exponentially with the number of variables, so one
+// pathological metafunction could otherwise take every node, byte and
+// second a build worker has.
+struct ConversionLimits {
+	uint64_t maxNodes = 0;        // IR nodes, of the input and made by the engine
+	uint64_t maxOutputBytes = 0;  // the result written without shared subterms
+	uint64_t timeoutMs = 0;       // time in the engine
+
+	bool Any() const { return maxNodes || maxOutputBytes || timeoutMs; }
+};
+
+enum class BudgetLimit { None, Nodes, OutputBytes, Time };
+
+// The option setting limit, with its value, for diagnostics:
+// "-max-nodes=100000".
+std::string BudgetLimitName(BudgetLimit limit, const ConversionLimits& limits);
+
+// What one conversion has spent against its limits. The engine spends it on
+// every node it makes and, once it is overspent, stops converting: whatever
+// it returns then is not a result, the caller discards it and falls back to
+// the pointful form. Safe to share between the threads of one conversion.
+class ConversionBudget {
+public:
+	explicit ConversionBudget(const ConversionLimits& limits)
+		: limits(limits), start(std::chrono::steady_clock::now()) {}
+
+	// Accounts for nodes of bytesEach bytes made by the engine. Returns
+	// false once any limit has been exceeded.
+	bool Spend(uint64_t nodes, uint64_t bytesEach);
+
+	// Whether any limit has been exceeded, checking the time as well.
+	bool Exceeded();
+
+	// Records that limit has been exceeded, for those checked by the caller.
+	void Exceed(BudgetLimit limit);
+
+	// The first limit exceeded, None while within the budget.
+	BudgetLimit Limit() const { return exceeded.load(); }
+
+	// The nodes spent so far and the bytes estimated for them, a node's
+	// size times their number. Nodes the engine frees are not given back,
+	// so these count allocations, not the IR alive at any one time.
+	uint64_t NodesAllocated() const { return nodes.load(); }
+	uint64_t BytesAllocated() const { return bytes.load(); }
+
+private:
+	// How many nodes are made between looks at the clock.
+	static const uint64_t ClockInterval = 1024;
+
+	ConversionLimits limits;
+	std::chrono::steady_clock::time_point start;
+
+	std::atomic<uint64_t> nodes{0}, bytes{0};
+	std::atomic<BudgetLimit> exceeded{BudgetLimit::None};
+};
@@ -0,0 +1,546 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#include "ConversionMemo.h"
+
+#include <algorithm>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+// Keys and saved results are written as
+//
+//   A <function> <argument>          an application
+//   L <body>                         a lambda
+//   B <level> ; <wrapper>            a bound variable
+//   V <name> <wrapper>               a free variable
+//
+// where a name or wrapper is its length, ':' and its characters, so that
+// any name can be read back.
+static void WriteString(const std::string& text, std::string& out) {
+	out += std::to_string(text.size());
+	out += ':';
+	out += text;
+}
+
+static bool WriteKey(CExpr* expr, std::unordered_map<std::string, std::vector<unsigned>>& env,
+                     unsigned depth, unsigned& budget, std::string& out) {
+	if (budget == 0)
+		return false;
+	--budget;
+
+	if (Var* var = dynamic_cast<Var*>(expr)) {
+		auto it = env.find(var->name);
+		if (it != env.end() && !it->second.empty()) {
+			out += 'B';
+			out += std::to_string(it->second.back());
+			out += ';';
+		} else {
+			out += 'V';
+			WriteString(var->name, out);
+		}
+		WriteString(var->curtainsWrapper, out);
+		return true;
+	}
+
+	if (App* app = dynamic_cast<App*>(expr)) {
+		out += 'A';
+		return WriteKey(app->exprL, env, depth, budget, out) && WriteKey(app->exprR, env, depth, budget, out);
+	}
+
+	if (CLambda* lambda = dynamic_cast<CLambda*>(expr)) {
+		PVar* pVar = dynamic_cast<PVar*>(lambda->pat);
+		if (pVar == nullptr)
+			return false;
+
+		out += 'L';
+		env[pVar->name].push_back(depth);
+		bool written = WriteKey(lambda->expr, env, depth + 1, budget, out);
+		env[pVar->name].pop_back();
+		return written;
+	}
+
+	return false;
+}
+
+bool CanonicalKey(CExpr* expr, std::string& key, unsigned maxNodes) {
+	std::unordered_map<std::string, std::vector<unsigned>> env;
+	unsigned budget = maxNodes;
+
+	key.clear();
+	if (!WriteKey(expr, env, 0, budget, key)) {
+		key.clear();
+		return false;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////
+/* Shapes 															  */
+////////////////////////////////////////////////////////////////////////
+
+// A prepared text is written as keys are, except that a bound variable is
+//
+//   B <level> ; <name> <wrapper>
+//
+// where level is the number of lambdas around its binder in the whole
+// term, so that any lambda's key can be written from it.
+//
+// The hash is the polynomial one of the nodes in the order keys write
+// them, taken modulo the prime 2^61 - 1: the node at position i within the
+// lambda being hashed adds its token times Base^i. An application or a
+// lambda has a token of its own, a variable the hash of its name, or
+// C * Level^k if it is bound k lambdas below the lambda being hashed. Being
+// linear, the hash of every lambda follows from sums gathered over the
+// whole term by absolute positions and levels, only the uses of the
+// variable a lambda binds have to be moved from the first form to the
+// second when it is reached.
+static const std::uint64_t Prime = (std::uint64_t(1) << 61) - 1;
+static const std::uint64_t AppToken = 0x1f3d5b79a2c4e6ull, LambdaToken = 0x5851f42d4c957ull,
+                           Base = 0x9e3779b97f4a7ull, LevelBase = 0xd6e8feb86659fdull;
+
+static std::uint64_t Add(std::uint64_t a, std::uint64_t b) {
+	std::uint64_t sum = a + b;
+	return sum >= Prime ? sum - Prime : sum;
+}
+
+static std::uint64_t Subtract(std::uint64_t a, std::uint64_t b) {
+	return a >= b ? a - b : a + Prime - b;
+}
+
+static std::uint64_t Multiply(std::uint64_t a, std::uint64_t b) {
+	// with 2^61 = 1, from the 32 bit halves of a and b
+	std::uint64_t low = (a & 0xffffffff) * (b & 0xffffffff);
+	std::uint64_t middle = (a >> 32) * (b & 0xffffffff) + (a & 0xffffffff) * (b >> 32);
+	std::uint64_t high = (a >> 32) * (b >> 32);
+
+	std::uint64_t product = (low & Prime) + (low >> 61) + (high << 3)
+	                      + (middle >> 29) + ((middle & ((std::uint64_t(1) << 29) - 1)) << 32);
+	product = (product & Prime) + (product >> 61);
+	product = (product & Prime) + (product >> 61);
+	return product >= Prime ? product - Prime : product;
+}
+
+static std::uint64_t Inverse(std::uint64_t a) {
+	std::uint64_t result = 1;
+	for (std::uint64_t exponent = Prime - 2; exponent; exponent >>= 1) {
+		if (exponent & 1)
+			result = Multiply(result, a);
+		a = Multiply(a, a);
+	}
+	return result;
+}
+
+// FNV-1a, never 0.
+static std::uint64_t HashString(const std::string& text, std::uint64_t hash = 0xcbf29ce484222325ull) {
+	for (unsigned char c : text) {
+		hash ^= c;
+		hash *= 0x100000001b3ull;
+	}
+	hash %= Prime;
+	return hash ? hash : 1;
+}
+
+namespace {
+
+// Powers of a base and of its inverse, made as they are needed.
+class Powers {
+public:
+	explicit Powers(std::uint64_t base) : base(base), inverseBase(Inverse(base)) {}
+
+	std::uint64_t Of(std::size_t exponent) { Extend(exponent); return powers[exponent]; }
+	std::uint64_t InverseOf(std::size_t exponent) { Extend(exponent); return inverses[exponent]; }
+
+private:
+	void Extend(std::size_t exponent) {
+		while (powers.size() <= exponent) {
+			powers.push_back(Multiply(powers.back(), base));
+			inverses.push_back(Multiply(inverses.back(), inverseBase));
+		}
+	}
+
+	std::uint64_t base, inverseBase;
+	std::vector<std::uint64_t> powers{1}, inverses{1};
+};
+
+struct Binder {
+	// the sums of the uses of the variable seen so far, as names and as
+	// levels, by absolute position
+	std::uint64_t named, leveled;
+};
+
+struct Part {
+	std::uint64_t bound;   // the uses of variables bound inside, by level
+	std::uint64_t unbound; // everything else
+	bool keyable;
+};
+
+class ShapeWriter {
+public:
+	ShapeWriter(const std::shared_ptr<std::string>& text, unsigned maxNodes)
+		: text(text), maxNodes(maxNodes), positions(Base), levels(LevelBase) {}
+
+	Part Write(CExpr* expr) {
+		std::size_t position = nodes++;
+		std::uint64_t weight = positions.Of(position);
+
+		if (Var* var = dynamic_cast<Var*>(expr)) {
+			std::uint64_t wrapper = HashString(var->curtainsWrapper);
+			std::uint64_t named = Multiply(weight, HashString(var->name, wrapper));
+
+			auto it = env.find(var->name);
+			if (it != env.end() && !it->second.empty()) {
+				Binder& binder = binders[it->second.back()];
+				binder.named = Add(binder.named, named);
+				binder.leveled = Add(binder.leveled, Multiply(weight, wrapper));
+				*text += 'B';
+				*text += std::to_string(it->second.back());
+				*text += ';';
+				WriteString(var->name, *text);
+			} else {
+				*text += 'V';
+				WriteString(var->name, *text);
+			}
+			WriteString(var->curtainsWrapper, *text);
+			return Part{0, named, true};
+		}
+
+		if (App* app = dynamic_cast<App*>(expr)) {
+			*text += 'A';
+			Part f = Write(app->exprL);
+			Part x = Write(app->exprR);
+			return Part{Add(f.bound, x.bound), Add(Multiply(weight, AppToken), Add(f.unbound, x.unbound)),
+			            f.keyable && x.keyable};
+		}
+
+		if (CLambda* lambda = dynamic_cast<CLambda*>(expr)) {
+			std::size_t begin = text->size();
+			unsigned level = binders.size();
+
+			PVar* pVar = dynamic_cast<PVar*>(lambda->pat);
+			binders.push_back(Binder{0, 0});
+			if (pVar)
+				env[pVar->name].push_back(level);
+
+			*text += 'L';
+			Part body = Write(lambda->expr);
+
+			Binder binder = binders.back();
+			binders.pop_back();
+			if (pVar)
+				env[pVar->name].pop_back();
+
+			// the uses of the variable move from the names to the levels
+			Part part{Add(body.bound, Multiply(binder.leveled, levels.Of(level))),
+			          Add(Multiply(weight, LambdaToken), Subtract(body.unbound, binder.named)),
+			          body.keyable && pVar != nullptr};
+
+			// positions and levels counted from the lambda's own
+			if (part.keyable && nodes - position <= maxNodes) {
+				std::uint64_t hash = Multiply(Add(Multiply(part.bound, levels.InverseOf(level)), part.unbound),
+				                              positions.InverseOf(position));
+				lambda->shape = std::make_shared<MemoShape>(MemoShape{text, begin, hash, level});
+			}
+			return part;
+		}
+
+		return Part{0, 0, false};
+	}
+
+private:
+	std::shared_ptr<std::string> text;
+	unsigned maxNodes;
+
+	std::size_t nodes = 0; // written so far, the position of the next one
+	Powers positions, levels;
+
+	// the lambdas around the subterm, by level, and where each name is bound
+	std::vector<Binder> binders;
+	std::unordered_map<std::string, std::vector<unsigned>> env;
+};
+
+} // namespace
+
+static bool WriteShapeKey(const std::string& text, std::size_t& pos, unsigned level, std::string& out);
+
+std::string MemoShape::Key() const {
+	std::string key;
+	std::size_t pos = begin;
+	WriteShapeKey(*text, pos, level, key);
+	return key;
+}
+
+void ConversionMemo::Prepare(CExpr* term) const {
+	auto text = std::make_shared<std::string>();
+	ShapeWriter(text, maxNodes).Write(term);
+}
+
+ConversionMemo::~ConversionMemo() {
+	for (auto& result : results)
+		delete result.second.pf;
+}
+
+ConversionMemo::Result* ConversionMemo::Lookup(const MemoShape& shape, std::string& key) {
+	auto range = results.equal_range(shape.hash);
+
+	// the hashes are only compared, the keys confirm a match
+	for (auto it = range.first; it != range.second; ++it) {
+		if (key.empty())
+			key = shape.Key();
+		if (it->second.key == key)
+			return &it->second;
+	}
+
+	return nullptr;
+}
+
+CExpr* ConversionMemo::Find(const MemoShape& shape) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::string key;
+	Result* result = Lookup(shape, key);
+	if (result == nullptr) {
+		++misses;
+		return nullptr;
+	}
+
+	++hits;
+	return Clone(result->pf);
+}
+
+void ConversionMemo::Insert(const MemoShape& shape, CExpr* pf) {
+	if (pf == nullptr)
+		return;
+
+	// written once, so the entry needn't keep the prepared text alive
+	std::string key = shape.Key();
+	CExpr* copy = Clone(pf);
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (Lookup(shape, key)) {
+		delete copy;
+		return;
+	}
+
+	results.insert(std::make_pair(shape.hash, Result{std::move(key), copy}));
+}
+
+////////////////////////////////////////////////////////////////////////
+/* Saved Results 													  */
+////////////////////////////////////////////////////////////////////////
+
+static const char* MemoHeader = "point-free memo 1";
+
+static bool ReadString(const std::string& text, std::size_t& pos, std::string& out) {
+	std::size_t colon = text.find(':', pos);
+	if (colon == std::string::npos || colon == pos)
+		return false;
+
+	std::size_t length = 0;
+	for (std::size_t i = pos; i < colon; ++i) {
+		if (text[i] < '0' || text[i] > '9')
+			return false;
+		length = length * 10 + (text[i] - '0');
+	}
+
+	if (colon + 1 + length > text.size())
+		return false;
+
+	out = text.substr(colon + 1, length);
+	pos = colon + 1 + length;
+	return true;
+}
+
+static bool ReadLevel(const std::string& text, std::size_t& pos, unsigned& level) {
+	std::size_t semicolon = text.find(';', pos);
+	if (semicolon == std::string::npos || semicolon == pos)
+		return false;
+
+	level = 0;
+	for (std::size_t i = pos; i < semicolon; ++i) {
+		if (text[i] < '0' || text[i] > '9')
+			return false;
+		level = level * 10 + (text[i] - '0');
+	}
+
+	pos = semicolon + 1;
+	return true;
+}
+
+// Reads a key or a result, which has no lambdas, into result, or only
+// skips over it when result is nullptr. A key's lambdas bind "#" and the
+// number of lambdas around them, which no free name can be.
+static bool ReadTerm(const std::string& text, std::size_t& pos, CExpr** result,
+                     bool key, unsigned level = 0) {
+	if (pos >= text.size())
+		return false;
+
+	char tag = text[pos++];
+	std::string name, wrapper;
+	unsigned bound = 0;
+
+	switch (tag) {
+	case 'A': {
+		CExpr* function = nullptr;
+		CExpr* argument = nullptr;
+		if (!ReadTerm(text, pos, result ? &function : nullptr, key, level) ||
+		    !ReadTerm(text, pos, result ? &argument : nullptr, key, level)) {
+			delete function;
+			delete argument;
+			return false;
+		}
+		if (result)
+			*result = new App(function, argument);
+		return true;
+	}
+
+	case 'L': {
+		CExpr* body = nullptr;
+		if (!key || !ReadTerm(text, pos, result ? &body : nullptr, key, level + 1))
+			return false;
+		if (result)
+			*result = new CLambda(new PVar("#" + std::to_string(level)), body);
+		return true;
+	}
+
+	case 'B':
+		if (!key || !ReadLevel(text, pos, bound) || bound >= level || !ReadString(text, pos, wrapper))
+			return false;
+		name = "#" + std::to_string(bound);
+		break;
+
+	case 'V':
+		if (!ReadString(text, pos, name) || !ReadString(text, pos, wrapper))
+			return false;
+		break;
+
+	default:
+		return false;
+	}
+
+	if (result) {
+		Var* var = new Var(name);
+		var->curtainsWrapper = wrapper;
+		*result = var;
+	}
+	return true;
+}
+
+// Writes the CanonicalKey of the lambda at pos in a prepared text, which
+// has level lambdas around it.
+static bool WriteShapeKey(const std::string& text, std::size_t& pos, unsigned level, std::string& out) {
+	if (pos >= text.size())
+		return false;
+
+	char tag = text[pos++];
+	std::string name, wrapper;
+	unsigned bound = 0;
+
+	switch (tag) {
+	case 'A':
+		out += 'A';
+		return WriteShapeKey(text, pos, level, out) && WriteShapeKey(text, pos, level, out);
+
+	case 'L':
+		out += 'L';
+		return WriteShapeKey(text, pos, level, out);
+
+	case 'B':
+		if (!ReadLevel(text, pos, bound) || !ReadString(text, pos, name) || !ReadString(text, pos, wrapper))
+			return false;
+
+		// bound outside the lambda, its variable is a free one in the key
+		if (bound < level) {
+			out += 'V';
+			WriteString(name, out);
+		} else {
+			out += 'B';
+			out += std::to_string(bound - level);
+			out += ';';
+		}
+		WriteString(wrapper, out);
+		return true;
+
+	case 'V':
+		if (!ReadString(text, pos, name) || !ReadString(text, pos, wrapper))
+			return false;
+		out += 'V';
+		WriteString(name, out);
+		WriteString(wrapper, out);
+		return true;
+	}
+
+	return false;
+}
+
+bool ConversionMemo::Load(const std::string& path, std::string& error) {
+	std::ifstream file(path);
+	if (!file)
+		return true;
+
+	std::string line;
+	if (!std::getline(file, line) || line != MemoHeader) {
+		error = path + " is not a point-free memo file";
+		return false;
+	}
+
+	for (unsigned lineNumber = 2; std::getline(file, line); ++lineNumber) {
+		std::size_t pos = 0;
+		CExpr* lambda = nullptr;
+		CExpr* pf = nullptr;
+
+		if (!ReadTerm(line, pos, &lambda, true) || dynamic_cast<CLambda*>(lambda) == nullptr ||
+		    pos >= line.size() || line[pos] != '\t') {
+			delete lambda;
+			error = path + ":" + std::to_string(lineNumber) + ": malformed key";
+			return false;
+		}
+
+		++pos;
+
+		if (!ReadTerm(line, pos, &pf, false) || pos != line.size()) {
+			delete lambda;
+			delete pf;
+			error = path + ":" + std::to_string(lineNumber) + ": malformed result";
+			return false;
+		}
+
+		// the key is hashed as the lambda it was written for would be
+		Prepare(lambda);
+		if (const auto& shape = static_cast<CLambda*>(lambda)->shape)
+			Insert(*shape, pf);
+		delete lambda;
+		delete pf;
+	}
+
+	return true;
+}
+
+bool ConversionMemo::Save(const std::string& path, std::string& error) const {
+	std::ofstream file(path);
+
+	if (!file) {
+		error = "could not open " + path + " for writing";
+		return false;
+	}
+
+	std::vector<std::string> lines;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		// results hold no lambdas, so they are written as keys are
+		for (const auto& result : results) {
+			std::string value;
+			CanonicalKey(result.second.pf, value, ~0u);
+			lines.push_back(result.second.key + "\t" + value);
+		}
+	}
+
+	// in the same order every run, so saved files can be compared
+	std::sort(lines.begin(), lines.end());
+
+	file << MemoHeader << "\n";
+	for (const std::string& line : lines)
+		file << line << "\n";
+
+	return true;
+}
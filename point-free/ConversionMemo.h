@@ -0,0 +1,97 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#pragma once
+#include "Common.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+////////////////////////////////////////////////////////////////////////
+/* Conversion Memo 													  */
+////////////////////////////////////////////////////////////////////////
+
+// Writes a form of expr that is the same for any two expressions that only
+// differ in the names of their bound variables, in one pass. A bound name
+// is written as the number of lambdas around its binder within expr, free
+// names are written as they are:
+//
+//   \a b -> f (g a) b   and   \x y -> f (g x) y
+//
+// both give the same key. Returns false, leaving key empty, if expr has a
+// pattern other than a variable or more than maxNodes nodes.
+bool CanonicalKey(CExpr* expr, std::string& key, unsigned maxNodes);
+
+// What the memo knows of a lambda of a prepared term. Rather than a key of
+// its own, which would make the keys of nested lambdas cost the square of
+// their depth, every lambda of a term refers to one text written for the
+// whole term, its part starting at begin, and is looked up by a hash of its
+// CanonicalKey that Prepare works out for all of them in the same pass. The
+// key itself is only written when the hash matches a remembered one, to
+// confirm it, or when a result is remembered, which keeps the key rather
+// than the text, so that a small lambda doesn't hold on to a large term.
+struct MemoShape {
+	std::shared_ptr<const std::string> text;
+	std::size_t begin;
+	std::uint64_t hash;
+	unsigned level; // the number of lambdas around the lambda in the term
+
+	// The CanonicalKey of the lambda.
+	std::string Key() const;
+};
+
+// Maps the canonical keys of lambda terms to their point-free results, so
+// that a shape which recurs, in one metafunction or across several, is only
+// converted once. The algorithm only ever compares names, so the result of
+// one term is the result of every term with the same key. Safe to use from
+// several threads at once.
+class ConversionMemo {
+public:
+	// Terms of more than maxNodes nodes aren't remembered, they rarely
+	// recur and their results would cost as much memory as the terms.
+	explicit ConversionMemo(unsigned maxNodes = 4096) : maxNodes(maxNodes) {}
+	~ConversionMemo();
+
+	ConversionMemo(const ConversionMemo&) = delete;
+	ConversionMemo& operator=(const ConversionMemo&) = delete;
+
+	// Sets the shape of every lambda in term that can be remembered, in
+	// time linear in the size of term.
+	void Prepare(CExpr* term) const;
+
+	// A copy of the result remembered for the shape, owned by the caller,
+	// or nullptr.
+	CExpr* Find(const MemoShape& shape);
+
+	// Remembers a copy of pf as the result for the shape. Only the shape's
+	// key is kept, not the text of the term it was prepared from.
+	void Insert(const MemoShape& shape, CExpr* pf);
+
+	// Reads results saved by an earlier run, a missing file is not an
+	// error. Returns false and sets error if the file is malformed.
+	bool Load(const std::string& path, std::string& error);
+
+	// Writes every result remembered so far to path.
+	bool Save(const std::string& path, std::string& error) const;
+
+	unsigned Hits() const { std::lock_guard<std::mutex> lock(mutex); return hits; }
+	unsigned Misses() const { std::lock_guard<std::mutex> lock(mutex); return misses; }
+
+private:
+	struct Result {
+		std::string key;
+		CExpr* pf;
+	};
+
+	// The result remembered for shape, nullptr if there is none. key is
+	// shape's key, written here if it is empty and needed. The mutex is
+	// held.
+	Result* Lookup(const MemoShape& shape, std::string& key);
+
+	unsigned maxNodes;
+	unsigned hits = 0, misses = 0;
+
+	mutable std::mutex mutex;
+	std::unordered_multimap<std::uint64_t, Result> results;
+};
@@ -0,0 +1,298 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#include "ExprPool.h"
+#include "ConversionBudget.h"
+
+#include <algorithm>
+#include <cassert>
+
+ExprPool::ExprPool() {
+	Intern("");
+}
+
+ExprPool::Symbol ExprPool::Intern(const std::string& name) {
+	auto it = symbolIds.find(name);
+	if (it != symbolIds.end())
+		return it->second;
+
+	Symbol symbol = static_cast<Symbol>(names.size());
+	names.push_back(name);
+	symbolIds.insert(std::make_pair(name, symbol));
+	return symbol;
+}
+
+ExprPool::Node ExprPool::AddVar(Symbol name, Symbol wrapper) {
+	kinds.push_back(VarNode);
+	symbols.push_back(name);
+	lefts.push_back(0);
+	rights.push_back(wrapper);
+	firsts.push_back(static_cast<Node>(kinds.size() - 1));
+	return static_cast<Node>(kinds.size() - 1);
+}
+
+ExprPool::Node ExprPool::AddApp(Node function, Node argument) {
+	kinds.push_back(AppNode);
+	symbols.push_back(0);
+	lefts.push_back(function);
+	rights.push_back(argument);
+	firsts.push_back(std::min(firsts[function], firsts[argument]));
+	return static_cast<Node>(kinds.size() - 1);
+}
+
+ExprPool::Node ExprPool::AddLambda(Symbol bound, Node body) {
+	kinds.push_back(LambdaNode);
+	symbols.push_back(bound);
+	lefts.push_back(body);
+	rights.push_back(0);
+	firsts.push_back(firsts[body]);
+	return static_cast<Node>(kinds.size() - 1);
+}
+
+// Renames as AlphaRename does, each bound name becomes "$" followed by the
+// number of names bound around it, so the results of the two engines can
+// be compared name for name.
+ExprPool::Node ExprPool::Import(CExpr* expr, std::unordered_map<std::string, std::vector<Symbol>>& env) {
+	if (Var* var = dynamic_cast<Var*>(expr)) {
+		std::string name = (var->name == "*") ? "add_pointer_t" : var->name;
+
+		auto it = env.find(var->name);
+		Symbol symbol = (it != env.end() && !it->second.empty()) ? it->second.back() : Intern(name);
+		return AddVar(symbol, Intern(var->curtainsWrapper));
+	}
+
+	if (App* app = dynamic_cast<App*>(expr)) {
+		Node function = Import(app->exprL, env);
+		Node argument = Import(app->exprR, env);
+
+		// Shuffle
+		if (KindOf(argument) == VarNode && Name(SymbolOf(argument)) == "add_pointer_t")
+			return AddApp(argument, function);
+
+		return AddApp(function, argument);
+	}
+
+	if (CLambda* lambda = dynamic_cast<CLambda*>(expr)) {
+		PVar* pVar = dynamic_cast<PVar*>(lambda->pat);
+		assert(pVar && "only variable patterns are converted");
+
+		Symbol bound = Intern("$" + std::to_string(boundNames++));
+		env[pVar->name].push_back(bound);
+		Node body = Import(lambda->expr, env);
+		env[pVar->name].pop_back();
+		--boundNames;
+
+		return AddLambda(bound, body);
+	}
+
+	assert(false && "unknown expression");
+	return 0;
+}
+
+ExprPool::Node ExprPool::Import(CExpr* expr) {
+	std::unordered_map<std::string, std::vector<Symbol>> env;
+	boundNames = 0;
+	return Import(expr, env);
+}
+
+CExpr* ExprPool::Export(Node node) const {
+	switch (KindOf(node)) {
+	case VarNode: {
+		Var* var = new Var(Name(SymbolOf(node)));
+		var->curtainsWrapper = Name(Wrapper(node));
+		return var;
+	}
+	case AppNode:
+		return new App(Export(Left(node)), Export(Right(node)));
+	case LambdaNode:
+		return new CLambda(new PVar(Name(SymbolOf(node))), Export(Left(node)));
+	}
+
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////
+/* Point-Free Algorithm 											  */
+////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Whether one name is free in each node from the first node below a body
+// on, filled in by scanning forward to the node asked about. Children come
+// before their parents, so every node is decided by looking at nodes already
+// scanned. Nodes made from the body later are scanned as they're asked
+// about, they can't refer to anything before first. Nodes made from other
+// parts of the expression can, what they're given is never asked.
+class FreeScan {
+public:
+	FreeScan(const ExprPool& pool, ExprPool::Symbol name, ExprPool::Node body)
+		: pool(pool), name(name), first(pool.First(body)) {}
+
+	bool IsFreeIn(ExprPool::Node node) {
+		assert(node >= first);
+		if (node - first >= free.size())
+			Extend(node);
+		return free[node - first] != 0;
+	}
+
+	ExprPool::Symbol Name() const { return name; }
+
+private:
+	void Extend(ExprPool::Node last) {
+		std::size_t begin = first + free.size();
+		free.resize(last - first + 1);
+
+		for (std::size_t node = begin; node <= last; ++node) {
+			ExprPool::Node n = static_cast<ExprPool::Node>(node);
+			switch (pool.KindOf(n)) {
+			case ExprPool::VarNode:
+				Free(n) = pool.SymbolOf(n) == name;
+				break;
+			case ExprPool::AppNode:
+				Free(n) = Scanned(pool.Left(n)) | Scanned(pool.Right(n));
+				break;
+			case ExprPool::LambdaNode:
+				Free(n) = (pool.SymbolOf(n) == name) ? 0 : Scanned(pool.Left(n));
+				break;
+			}
+		}
+	}
+
+	uint8_t& Free(ExprPool::Node node) { return free[node - first]; }
+	uint8_t Scanned(ExprPool::Node node) { return node < first ? 0 : Free(node); }
+
+	const ExprPool& pool;
+	ExprPool::Symbol name;
+	ExprPool::Node first;
+	std::vector<uint8_t> free;
+};
+
+// RemoveVariable and TransformRecursive from Common.cpp, case for case.
+// Nodes are never changed, a transformed App is a new node. With a budget,
+// a node is returned as it is once the budget is overspent.
+class FlatTransform {
+public:
+	FlatTransform(ExprPool& pool, ConversionBudget* budget) : pool(pool), budget(budget) {
+		id = pool.Intern("id");
+		const_ = pool.Intern("const_");
+		S = pool.Intern("S");
+		flip = pool.Intern("flip");
+		compose = pool.Intern("compose");
+	}
+
+	ExprPool::Node RemoveVariable(FreeScan& scan, ExprPool::Node node) {
+		if (!WithinBudget())
+			return node;
+
+		switch (pool.KindOf(node)) {
+		case ExprPool::VarNode:
+			if (pool.SymbolOf(node) == scan.Name())
+				return Combinator(id);
+			return pool.AddApp(Combinator(const_), node);
+
+		case ExprPool::LambdaNode:
+			assert(pool.SymbolOf(node) != scan.Name());
+			return RemoveVariable(scan, TransformRecursive(node));
+
+		case ExprPool::AppNode: {
+			ExprPool::Node left = pool.Left(node), right = pool.Right(node);
+			bool frL = scan.IsFreeIn(left);
+			bool frR = scan.IsFreeIn(right);
+
+			if (frL && frR) {
+				ExprPool::Node l = RemoveVariable(scan, left);
+				ExprPool::Node r = RemoveVariable(scan, right);
+				return pool.AddApp(pool.AddApp(Combinator(S), l), r);
+			} else if (frL) {
+				ExprPool::Node l = RemoveVariable(scan, left);
+				return pool.AddApp(pool.AddApp(Combinator(flip), l), right);
+			} else if (pool.KindOf(right) == ExprPool::VarNode && pool.SymbolOf(right) == scan.Name()) {
+				return left;
+			} else if (frR) {
+				ExprPool::Node r = RemoveVariable(scan, right);
+				return pool.AddApp(pool.AddApp(Combinator(compose), left), r);
+			}
+			return pool.AddApp(Combinator(const_), node);
+		}
+		}
+
+		return node;
+	}
+
+	ExprPool::Node TransformRecursive(ExprPool::Node node) {
+		if (!WithinBudget())
+			return node;
+
+		switch (pool.KindOf(node)) {
+		case ExprPool::VarNode:
+			return node;
+
+		case ExprPool::AppNode: {
+			ExprPool::Node left = TransformRecursive(pool.Left(node));
+			ExprPool::Node right = TransformRecursive(pool.Right(node));
+			if (left == pool.Left(node) && right == pool.Right(node))
+				return node;
+			return pool.AddApp(left, right);
+		}
+
+		case ExprPool::LambdaNode: {
+			FreeScan scan(pool, pool.SymbolOf(node), pool.Left(node));
+			return TransformRecursive(RemoveVariable(scan, pool.Left(node)));
+		}
+		}
+
+		return node;
+	}
+
+	// Spends the nodes added to the pool since the last call, the imported
+	// ones the first time. False once the budget is overspent.
+	bool WithinBudget() {
+		if (budget == nullptr)
+			return true;
+
+		std::size_t size = pool.Size();
+		bool within = budget->Spend(size - spent, ExprPool::NodeBytes);
+		spent = size;
+		return within;
+	}
+
+private:
+	ExprPool::Node Combinator(ExprPool::Symbol name) {
+		return pool.AddVar(name, pool.NoWrapper());
+	}
+
+	ExprPool& pool;
+	ExprPool::Symbol id, const_, S, flip, compose;
+
+	ConversionBudget* budget;
+	std::size_t spent = 0;
+};
+
+// Only variable patterns are converted, like TransformRecursive.
+bool Convertible(CExpr* expr) {
+	if (App* app = dynamic_cast<App*>(expr))
+		return Convertible(app->exprL) && Convertible(app->exprR);
+
+	if (CLambda* lambda = dynamic_cast<CLambda*>(expr))
+		return dynamic_cast<PVar*>(lambda->pat) && Convertible(lambda->expr);
+
+	return dynamic_cast<Var*>(expr) != nullptr;
+}
+
+} // namespace
+
+CExpr* PointFreeFlat(CExpr* expr, ConversionBudget* budget) {
+	if (!Convertible(expr)) {
+		delete expr;
+		return nullptr;
+	}
+
+	ExprPool pool;
+	ExprPool::Node root = pool.Import(expr);
+	delete expr;
+
+	FlatTransform transform(pool, budget);
+	ExprPool::Node pf = transform.TransformRecursive(root);
+	if (!transform.WithinBudget())
+		return nullptr;
+
+	return pool.Export(pf);
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#pragma once
+#include "Common.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////
+/* Flat Expression Pool 											  */
+////////////////////////////////////////////////////////////////////////
+
+// An alternative layout for the intermediate structure, for very large
+// terms. Rather than a tree of heap allocated CExpr objects, nodes are
+// 32-bit indices into parallel arrays:
+//
+//   kind     Var        App        Lambda
+//   symbol   name       -          bound name
+//   left     -          function   body
+//   right    wrapper    argument   -
+//   first    the lowest node below it, or itself
+//
+// which costs 17 bytes a node, names are interned as 32-bit symbols. Nodes
+// are never modified and a node's children are always added before it, so
+// a question about every node below some node, such as which of them a name
+// is free in, is answered by one forward scan over the arrays from first.
+class ExprPool {
+public:
+	enum Kind : uint8_t { VarNode, AppNode, LambdaNode };
+	typedef uint32_t Node;
+	typedef uint32_t Symbol;
+
+	ExprPool();
+
+	Symbol Intern(const std::string& name);
+	const std::string& Name(Symbol symbol) const { return names[symbol]; }
+
+	// The symbol of "", for a Var without a Curtains wrapper.
+	Symbol NoWrapper() const { return 0; }
+
+	Node AddVar(Symbol name, Symbol wrapper);
+	Node AddApp(Node function, Node argument);
+	Node AddLambda(Symbol bound, Node body);
+
+	Kind KindOf(Node node) const { return static_cast<Kind>(kinds[node]); }
+	Symbol SymbolOf(Node node) const { return symbols[node]; }
+	Node Left(Node node) const { return lefts[node]; }
+	Node Right(Node node) const { return rights[node]; }
+	Symbol Wrapper(Node node) const { return rights[node]; }
+	Node First(Node node) const { return firsts[node]; }
+
+	std::size_t Size() const { return kinds.size(); }
+
+	// The bytes a node takes in the arrays.
+	static const std::size_t NodeBytes = sizeof(uint8_t) + 4 * sizeof(uint32_t);
+
+	// Adds expr, which is not modified, as PointFree sees it: bound names
+	// are made unique and '*' is rewritten as ConvertNonTypesToMetafunctions
+	// and Shuffle do.
+	Node Import(CExpr* expr);
+
+	// A CExpr tree for node, owned by the caller.
+	CExpr* Export(Node node) const;
+
+private:
+	Node Import(CExpr* expr, std::unordered_map<std::string, std::vector<Symbol>>& env);
+
+	std::vector<uint8_t> kinds;
+	std::vector<Symbol> symbols;
+	std::vector<Node> lefts;
+	std::vector<Node> rights;
+	std::vector<Node> firsts;
+
+	std::vector<std::string> names;
+	std::unordered_map<std::string, Symbol> symbolIds;
+	unsigned boundNames = 0;
+};
+
+// The Point-Free algorithm run on an ExprPool, giving the same result as
+// PointFree. The expression is consumed and the result is owned by the
+// caller, nullptr if expr could not be converted or, with a budget, when
+// the budget was overspent (see ConversionBudget.h).
+CExpr* PointFreeFlat(CExpr* expr, ConversionBudget* budget = nullptr);
@@ -0,0 +1,192 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#include "LambdaParser.h"
+
+#include <cctype>
+
+namespace {
+
+class LambdaParser {
+public:
+	LambdaParser(const std::string& t) : text(t), pos(0) {}
+
+	// Returns nullptr and sets error on malformed input.
+	CExpr* Parse() {
+		CExpr* expr = ParseTerm();
+
+		if (expr != nullptr) {
+			SkipSpace();
+			if (pos != text.size()) {
+				Fail("unexpected '" + std::string(1, text[pos]) + "'");
+				delete expr;
+				expr = nullptr;
+			}
+		}
+
+		return expr;
+	}
+
+	std::string error;
+
+private:
+	void SkipSpace() {
+		while (pos < text.size() && isspace((unsigned char)text[pos]))
+			++pos;
+	}
+
+	bool Peek(char c) {
+		SkipSpace();
+		return pos < text.size() && text[pos] == c;
+	}
+
+	bool PeekArrow() {
+		SkipSpace();
+		return text.compare(pos, 2, "->") == 0;
+	}
+
+	void Fail(const std::string& msg) {
+		if (error.empty())
+			error = msg + " at column " + std::to_string(pos + 1);
+	}
+
+	bool IsNameChar(char c) {
+		return isalnum((unsigned char)c) || c == '_' || c == '\'';
+	}
+
+	std::string ParseName() {
+		SkipSpace();
+		std::size_t start = pos;
+
+		// "*" on its own is the pointer type constructor, as in "\x -> x *"
+		if (pos < text.size() && text[pos] == '*')
+			return text.substr(pos++, 1);
+
+		if (text.compare(pos, 3, "...") == 0)
+			pos += 3;
+
+		while (pos < text.size()) {
+			if (IsNameChar(text[pos]))
+				++pos;
+			else if (text.compare(pos, 2, "::") == 0)
+				pos += 2;
+			else
+				break;
+		}
+
+		// a lone "..." is not a name
+		if (pos == start || !IsNameChar(text[pos - 1])) {
+			pos = start;
+			return "";
+		}
+
+		return text.substr(start, pos - start);
+	}
+
+	CExpr* ParseTerm() {
+		if (!Peek('\\'))
+			return ParseApp();
+
+		++pos;
+		CLambda *lambdaTop = nullptr, *lambdaCurr = nullptr;
+
+		while (!PeekArrow()) {
+			std::string name = ParseName();
+
+			if (name.empty()) {
+				Fail("expected a parameter name or '->'");
+				delete lambdaTop;
+				return nullptr;
+			}
+
+			CLambda* lambda = new CLambda(new PVar(name), nullptr);
+
+			if (lambdaTop == nullptr)
+				lambdaTop = lambdaCurr = lambda;
+			else {
+				lambdaCurr->expr = lambda;
+				lambdaCurr = lambda;
+			}
+		}
+
+		if (lambdaTop == nullptr) {
+			Fail("lambda without parameters");
+			return nullptr;
+		}
+
+		pos += 2;
+		lambdaCurr->expr = ParseTerm();
+
+		if (lambdaCurr->expr == nullptr) {
+			delete lambdaTop;
+			return nullptr;
+		}
+
+		return lambdaTop;
+	}
+
+	CExpr* ParseApp() {
+		CExpr* expr = ParseAtom();
+
+		if (expr == nullptr)
+			return nullptr;
+
+		// application is left associative, f a b == (f a) b, a trailing
+		// lambda is allowed as the last argument, f \x -> x == f (\x -> x)
+		for (;;) {
+			SkipSpace();
+			if (pos == text.size() || Peek(')'))
+				break;
+
+			CExpr* arg = Peek('\\') ? ParseTerm() : ParseAtom();
+
+			if (arg == nullptr) {
+				delete expr;
+				return nullptr;
+			}
+
+			expr = new App(expr, arg);
+		}
+
+		return expr;
+	}
+
+	CExpr* ParseAtom() {
+		if (Peek('(')) {
+			++pos;
+			CExpr* expr = ParseTerm();
+
+			if (expr == nullptr)
+				return nullptr;
+
+			if (!Peek(')')) {
+				Fail("expected ')'");
+				delete expr;
+				return nullptr;
+			}
+
+			++pos;
+			return expr;
+		}
+
+		std::string name = ParseName();
+
+		if (name.empty()) {
+			Fail(pos < text.size() ? "unexpected '" + std::string(1, text[pos]) + "'"
+			                       : "unexpected end of term");
+			return nullptr;
+		}
+
+		return new Var(name);
+	}
+
+	const std::string& text;
+	std::size_t pos;
+};
+
+} // namespace
+
+CExpr* ParseLambdaTerm(const std::string& text, std::string& error) {
+	LambdaParser parser(text);
+	CExpr* expr = parser.Parse();
+	error = parser.error;
+	return expr;
+}
@@ -0,0 +1,25 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#pragma once
+#include "Common.h"
+
+#include <string>
+
+////////////////////////////////////////////////////////////////////////
+/* Lambda Term Parser 												  */
+////////////////////////////////////////////////////////////////////////
+
+// Parses Haskell style lambda terms such as "\x y -> f (g x) y" straight
+// into the CLambda/App/Var structure used by the Point-Free algorithm,
+// without going through Clang. The grammar is:
+//
+//   term := '\' name+ '->' term | app
+//   app  := atom atom*
+//   atom := name | '(' term ')'
+//
+// Names may contain letters, digits, '_', '\'' and "::" qualifiers, and may
+// be prefixed with "..." to mark a parameter pack, a lone '*' is also a name.
+// A lambda body extends as far to the right as possible, as in Haskell.
+//
+// Returns nullptr and sets error to a description of the problem on
+// malformed input, the caller owns the returned expression.
+CExpr* ParseLambdaTerm(const std::string& text, std::string& error);
@@ -0,0 +1,47 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#include "Pipeline.h"
+
+#include <cassert>
+#include <utility>
+
+Pipeline::Pipeline(std::size_t capacity)
+	: capacity(capacity ? capacity : 1), worker(&Pipeline::Run, this) {}
+
+Pipeline::~Pipeline() {
+	Finish();
+}
+
+void Pipeline::Submit(std::function<void()> task) {
+	std::unique_lock<std::mutex> lock(mutex);
+	assert(!finishing && "task submitted after Finish");
+	notFull.wait(lock, [this] { return tasks.size() < capacity; });
+	tasks.push_back(std::move(task));
+	notEmpty.notify_one();
+}
+
+void Pipeline::Finish() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		finishing = true;
+	}
+	notEmpty.notify_one();
+
+	if (worker.joinable())
+		worker.join();
+}
+
+void Pipeline::Run() {
+	for (;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			notEmpty.wait(lock, [this] { return finishing || !tasks.empty(); });
+			if (tasks.empty())
+				return;
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		notFull.notify_one();
+		task();
+	}
+}
@@ -0,0 +1,41 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+////////////////////////////////////////////////////////////////////////
+/* Conversion Pipeline 												  */
+////////////////////////////////////////////////////////////////////////
+
+// Runs tasks on a worker thread of its own, one at a time and in the order
+// they were submitted. The tool submits the engine and output half of each
+// conversion, so that they overlap with Clang parsing the next file. At most
+// capacity tasks wait in the queue, Submit blocks while it is full so a
+// slow engine holds back the parser rather than piling up IR.
+class Pipeline {
+public:
+	explicit Pipeline(std::size_t capacity = 64);
+
+	// Finishes the remaining tasks.
+	~Pipeline();
+
+	void Submit(std::function<void()> task);
+
+	// Waits for every submitted task to be done, after which nothing more
+	// can be submitted.
+	void Finish();
+
+private:
+	void Run();
+
+	std::size_t capacity;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable notEmpty, notFull;
+	bool finishing = false;
+	std::thread worker;
+};
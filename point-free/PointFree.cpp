@@ -1,22 +1,25 @@
 // Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
 #include "clang/Driver/Options.h"
 #include "clang/AST/AST.h"
+#include "clang/ASTMatchers/ASTMatchers.h"
+#include "clang/ASTMatchers/ASTMatchFinder.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/RecursiveASTVisitor.h"
 #include "clang/Basic/SourceLocation.h"
-#include "clang/Format/Format.h"
-#include "clang/Frontend/ASTConsumers.h"
 #include "clang/Frontend/FrontendActions.h"
 #include "clang/Frontend/CompilerInstance.h"
+#include "clang/Lex/Lexer.h"
 #include "clang/Tooling/CommonOptionsParser.h"
 #include "clang/Tooling/Tooling.h"
-#include "clang/Tooling/Core/Replacement.h"
-#include "clang/Rewrite/Core/Rewriter.h"
 #include "clang/AST/Type.h"
+#include "llvm/Support/MemoryBuffer.h"
 
-#include "Common.h"
+#include "PointFreeVisitor.h"
 
+#include <algorithm>
+#include <set>
+#include <thread>
 #include <vector>
 #include <utility>
 #include <stack>
@@ -24,12 +27,14 @@
 #include <iostream>
 
 using namespace clang;
+using namespace clang::ast_matchers;
 using namespace clang::driver;
 using namespace clang::tooling;
 using namespace llvm;
+using namespace pointfree;
 
 // A help message for this specific tool can be added afterwards.
-static cl::extrahelp MoreHelp("\n-classname <structure or class name> used to specify the class to search for the type alias or definition you have specified. \n \n-membername <type alias or type definition> used to specify the type to search for within the specified class, this type in conjunction with the class you specified will be made into a point-free metafunction. \n");
+static cl::extrahelp MoreHelp("\n-classname <structure or class name> used to specify the class to search for the type alias or definition you have specified. \n \n-membername <type alias or type definition> used to specify the type to search for within the specified class, this type in conjunction with the class you specified will be made into a point-free metafunction. \n \n-discover converts every class template defined in the source files themselves that has a type or value member, when no source files are given every file in the compilation database is used. \n");
 
 
 // CommonOptionsParser declares HelpMessage with a description of the common
@@ -45,598 +50,446 @@ static cl::opt<std::string> ClassName(
 static cl::opt<std::string> MemberName(
 	"membername",cl::init(""),
 	cl::desc("The name of the using or type alias in the class you wish to convert"));
+
+static cl::opt<std::string> Cursor(
+	"cursor",cl::init(""),
+	cl::desc("<file>:<line>:<column>, convert the class template at this position rather than -classname, for editors"));
+
+static cl::opt<unsigned> FixExpansions(
+	"fix-expansions",cl::init(0),
+	cl::desc("How often a recursive metafunction is expanded into itself before the recursion is expressed with fix"));
+
+static cl::opt<std::string> AliasHeader(
+	"alias-header",cl::init(""),
+	cl::desc("Replace subterms repeated within an output by aliases, defined in this generated header"));
+
+static cl::opt<std::string> BatchHeaderFile(
+	"batch-header",cl::init(""),
+	cl::desc("Write every result to this generated header as an alias, with the subterms they share written once"));
+
+static cl::opt<std::string> BackendName(
+	"backend",cl::init("curtains"),
+	cl::desc("The metaprogramming library to write results for: curtains, mp11 (Boost.Mp11) or alias (plain C++17 alias templates)"));
+
+static cl::opt<bool> Verify(
+	"verify",cl::init(false),
+	cl::desc("Check every result against its metafunction by reducing both, without compiling anything"));
+
+static cl::opt<std::string> EmitVerification(
+	"emit-verification",cl::init(""),
+	cl::desc("Write a translation unit with static_asserts comparing every converted metafunction with its result"));
+
+static cl::opt<bool> RunVerification(
+	"run-verification",cl::init(false),
+	cl::desc("Also compile the -emit-verification unit, with the flags of the first source file"));
+
+static cl::opt<std::string> Format(
+	"format",cl::init("text"),
+	cl::desc("How results are written: text, or json for one JSON object per conversion and per error"));
+
+static cl::opt<bool> Pipelined(
+	"pipeline",cl::init(false),
+	cl::desc("Run the engine and output of each file's conversions on a second thread, overlapping with parsing the next file"));
+
+static cl::opt<unsigned> EngineThreads(
+	"engine-threads",cl::init(0),
+	cl::desc("Worker threads that help convert large metafunctions, 0 converts each on one thread"));
+
+static cl::opt<bool> FlatPool(
+	"flat-pool",cl::init(false),
+	cl::desc("Convert on a flat expression pool, which is faster for very large metafunctions"));
+
+static cl::opt<bool> Bulk(
+	"bulk",cl::init(false),
+	cl::desc("Remove every template parameter at once with routing combinators, whose result grows linearly with the number of parameters"));
+
+static cl::opt<bool> Memo(
+	"memo",cl::init(false),
+	cl::desc("Convert lambda terms that only differ in their variable names once, across every metafunction converted"));
+
+static cl::opt<std::string> MemoFile(
+	"memo-file",cl::init(""),
+	cl::desc("Keep the results of -memo in this file, read at startup and written at exit (implies -memo)"));
+
+static cl::opt<unsigned> MaxNodes(
+	"max-nodes",cl::init(0),
+	cl::desc("Give up on a conversion, keeping the metafunction pointful, when its IR grows past this many nodes, 0 for no limit"));
+
+static cl::opt<unsigned> MaxOutputBytes(
+	"max-output-bytes",cl::init(0),
+	cl::desc("Give up on a conversion, keeping the metafunction pointful, when its result is longer than this, 0 for no limit"));
+
+static cl::opt<unsigned> TimeoutMs(
+	"timeout-ms",cl::init(0),
+	cl::desc("Give up on a conversion, keeping the metafunction pointful, when the engine takes longer than this, 0 for no limit"));
+
+static cl::opt<bool> Concurrent(
+	"concurrent",cl::init(false),
+	cl::desc("Extract every class of a translation unit first, then convert them all in parallel, written in source order"));
+
+static cl::opt<bool> Prefilter(
+	"prefilter",cl::init(false),
+	cl::desc("Only parse the source files whose own text defines a class template named -classname, or any class template with -discover, every file in the compilation database when none are given"));
+
+static cl::opt<bool> Discover(
+	"discover",cl::init(false),
+	cl::desc("Find and convert every class template with a type or value member in the main files"));
 	
-Rewriter rewriter;
 bool foundStruct = false;
-std::stack<std::pair<std::string, std::string>> QualifierNameStack;
-	
-class PointFreeVisitor : public RecursiveASTVisitor<PointFreeVisitor> {
-private:
-    ASTContext *astContext; // used for getting additional AST info
-	
-	CExpr* TransformToCExpr(NestedNameSpecifier* nns) {		
-		if (nns->getKind() == NestedNameSpecifier::SpecifierKind::TypeSpec)
-			return TransformToCExpr(nns->getAsType());
-		
-		if (nns->getKind() == NestedNameSpecifier::SpecifierKind::TypeSpecWithTemplate)
-			return TransformToCExpr(nns->getAsType());
-		
-		if (nns->getKind() == NestedNameSpecifier::SpecifierKind::Identifier
-		||  nns->getKind() == NestedNameSpecifier::SpecifierKind::Global
-		||	nns->getKind() == NestedNameSpecifier::SpecifierKind::Super
-		||	nns->getKind() == NestedNameSpecifier::SpecifierKind::NamespaceAlias
-		||	nns->getKind() == NestedNameSpecifier::SpecifierKind::Namespace)
-			errs() << "Unhandled NestedNameSpecifier in ForwardNestedNameSpecifier \n"; 
-			
-		return nullptr;	
+bool verificationFailed = false;
+std::string TargetMemberName;
+std::string CursorFile;
+unsigned CursorLine = 0, CursorColumn = 0;
+std::string CursorError; // why nothing was converted at the cursor
+std::string AliasDefinitions;
+BatchHeader Batch;
+VerificationUnit Verification;
+bool JSONOutput = false;
+std::unique_ptr<Pipeline> ConversionPipeline;
+std::unique_ptr<TaskPool> EnginePool;
+std::unique_ptr<ConversionMemo> ResultMemo;
+ConversionLimits Limits;
+
+// Diagnostics from the tool itself, a JSON line on stdout with -format=json
+// so that they arrive in order with the results.
+static void ReportError(const std::string& message) {
+	if (JSONOutput) {
+		outs() << JSONRecord().AddString("error", message).Line();
+		outs().flush();
+	} else {
+		errs() << message << " \n";
 	}
-			
-	CExpr* TransformToCExpr(Expr* e) {						 
-		if (auto* dsdre = dyn_cast<DependentScopeDeclRefExpr>(e)) {
-			if (auto* tst = dyn_cast<TemplateSpecializationType>(dsdre->getQualifier()->getAsType())) 
-				QualifierNameStack.push(std::make_pair(tst->getTemplateName().getAsTemplateDecl()->getName(), dsdre->getDeclName().getAsString()));	
-			else
-				errs() << "A non-TemplateSpecializationType passed through \n";
-						 
-			return TransformToCExpr(dsdre->getQualifier());
-		}	
-		
-		if (auto* ueotte = dyn_cast<UnaryExprOrTypeTraitExpr>(e)) {		
-			if (ueotte->getKind() == UnaryExprOrTypeTrait::UETT_SizeOf)
-				return new App(new Var("sizeof"), new Var(ueotte->getTypeOfArgument().getAsString()));
-				
-			if (ueotte->getKind() == UnaryExprOrTypeTrait::UETT_AlignOf)
-				return new App(new Var("alignof"), new Var(ueotte->getTypeOfArgument().getAsString()));
-					
-			if (ueotte->getKind() == UnaryExprOrTypeTrait::UETT_OpenMPRequiredSimdAlign 
-			 || ueotte->getKind() == UnaryExprOrTypeTrait::UETT_VecStep) 
-				errs() << "Unhandled UnaryExprOrTypeTrait \n";
-		}
-		
-		if (auto* dre = dyn_cast<DeclRefExpr>(e)) {
-			if (dre->hasQualifier())
-				return TransformToCExpr(dre->getQualifier());
-				
-			return new Var(dre->getDecl()->getNameAsString()); 
-		}
-		
-		if (auto* sope = dyn_cast<SizeOfPackExpr>(e)) {
-			return new App(new Var("sizeof..."), new Var("..." + sope->getPack()->getNameAsString()));	
-		}
-		
-		if (auto* cble = dyn_cast<CXXBoolLiteralExpr>(e)) {
-			if (cble->getValue())
-				return new Var("true"); 
-			else 
-				return new Var("false");
-		}
-		
-		if (auto* il = dyn_cast<IntegerLiteral>(e)) {			 
-			return new Var(il->getValue().toString(10, true));					
-		}
-		
-		if (auto* cl = dyn_cast<CharacterLiteral>(e)) {
-			std::string s(1, (char)cl->getValue());
-			return new Var(s);	
-		}
-		
-		return nullptr;	
-	}			
+}
+const Backend* OutputBackend = nullptr;
 	
-	CExpr* TransformToCExpr(Decl* d) {
-		if (auto* ctpsd = dyn_cast<ClassTemplatePartialSpecializationDecl>(d)) {			
-			if (isFromTypeTraits(ctpsd->getNameAsString())) {
-				auto traitName = ctpsd->getNameAsString();
-				
-				if (traitName == std::get<0>(QualifierNameStack.top()) 
-				&& std::get<1>(QualifierNameStack.top()) == "value") {
-					traitName += "::v";				
-					
-					if (QualifierNameStack.size() > 0)
-						QualifierNameStack.pop();
-				}
-								
-				if (traitName == std::get<0>(QualifierNameStack.top())
-				 && std::get<1>(QualifierNameStack.top()) == "type") {
-					traitName += "::t";			
-
-					if (QualifierNameStack.size() > 0)
-						QualifierNameStack.pop();
-				}
-							
-				return new Var(traitName);									
-			}
-			
-			for (auto i = ctpsd->decls_begin(), e = ctpsd->decls_end(); i != e; i++) {					
-				CLambda *tCLambdaTop = nullptr, *tCLambdaCurr = nullptr;
-				std::string pVarName = "";
-				
-				for(auto i = ctpsd->getTemplateParameters()->begin(), e = ctpsd->getTemplateParameters()->end(); i != e; i++) {	
-					pVarName = ((*i)->isParameterPack()) ? ("..." + (*i)->getNameAsString()) : (*i)->getNameAsString();
-					
-					if (tCLambdaTop == nullptr) {
-						tCLambdaTop = tCLambdaCurr = new CLambda(); 
-						tCLambdaCurr->pat = new PVar(pVarName); 
-					} else {
-						tCLambdaCurr->expr = new CLambda();
-						tCLambdaCurr = dynamic_cast<CLambda*>(tCLambdaCurr->expr); 	
-						tCLambdaCurr->pat = new PVar(pVarName);
-					}
-				}
-			   
-			    if (auto* nd = dyn_cast<NamedDecl>(*i)) {
-					if (ctpsd->getNameAsString() == std::get<0>(QualifierNameStack.top())
-					 && nd->getNameAsString() == std::get<1>(QualifierNameStack.top())) {
-					
-						if (QualifierNameStack.size() > 0)
-							QualifierNameStack.pop();
-										
-						tCLambdaCurr->expr = TransformToCExpr(*i);
-						return tCLambdaTop;
-					}
-				}
-			}
-				
-			return nullptr;
-		}
-		
-		// I don't treat full specialization as a lambda as technically it has no template parameters 
-		// (they're all fixed/constant arguments) I'm unsure of a case where the specialized arguments 
-		// would have to be treated as lambda parameters 
-		if (auto* ctsd = dyn_cast<ClassTemplateSpecializationDecl>(d)) {
-			if(isFromTypeTraits(ctsd->getNameAsString())) {
-				std::string traitName = ctsd->getNameAsString();
-				
-				if (traitName == std::get<0>(QualifierNameStack.top()) 
-				&& std::get<1>(QualifierNameStack.top()) == "value") {
-					traitName += "::v";				
-					
-					if (QualifierNameStack.size() > 0)
-						QualifierNameStack.pop();
-				}
-								
-				if (traitName == std::get<0>(QualifierNameStack.top())
-				 && std::get<1>(QualifierNameStack.top()) == "type") {
-					traitName += "::t";			
-
-					if (QualifierNameStack.size() > 0)
-						QualifierNameStack.pop();
-				}
-							
-				return new Var(traitName);									
-			}
-			
-			for (auto i = ctsd->decls_begin(), e = ctsd->decls_end(); i != e; i++) {					
-			    if (auto* nd = dyn_cast<NamedDecl>(*i)) {
-					if (ctsd->getNameAsString() == std::get<0>(QualifierNameStack.top())
-					&& nd->getNameAsString() == std::get<1>(QualifierNameStack.top())) {
-				
-						if (QualifierNameStack.size() > 0)
-							QualifierNameStack.pop();
-										
-						return TransformToCExpr(*i);
-					}
-				}
-			}
-		
-			return nullptr;			
-		}
+class PointFreeFrontendAction : public ASTFrontendAction {
+private:
+    PointFreeASTConsumer* consumer = nullptr;
 
-		if (auto* tad = dyn_cast<TypeAliasDecl>(d)) {	
-			return TransformToCExpr(tad->getUnderlyingType().getTypePtr());
-		}	
-
-		if (auto* tatd = dyn_cast<TypeAliasTemplateDecl>(d)) {		
-			if (isFromTypeTraits(tatd->getNameAsString())) {			
-				std::string traitName = tatd->getNameAsString();
-				
-				if (traitName == std::get<0>(QualifierNameStack.top()) && std::get<1>(QualifierNameStack.top()) == "value") {
-					traitName += "::v";				
-					
-					if (QualifierNameStack.size() > 0)
-						QualifierNameStack.pop();
-				}
-								
-				if (traitName == std::get<0>(QualifierNameStack.top()) && std::get<1>(QualifierNameStack.top()) == "type") {
-					traitName += "::t";			
-
-					if (QualifierNameStack.size() > 0)
-						QualifierNameStack.pop();
-				}
-							
-				return new Var(traitName);									
-			}
-								 
-			return TransformToCExpr(tatd->getTemplatedDecl());
-		}
-		
-		if (auto* td = dyn_cast<TypedefDecl>(d)) {
-			return TransformToCExpr(td->getUnderlyingType().getTypePtr());		
-		}
-	
-		if (auto* vd = dyn_cast<VarDecl>(d)) {
-			if (vd->hasInit())		 
-				return TransformToCExpr(vd->getInit());
-		}
-		
-		if (auto* fd = dyn_cast<FieldDecl>(d)) {
-		  if (fd->hasInClassInitializer())
-			  return TransformToCExpr(fd->getInClassInitializer()); 			
-		}
-			
-		if (auto* crd = dyn_cast<CXXRecordDecl>(d)) { 
-			if (std::get<0>(QualifierNameStack.top()) == ""
-			 && std::get<1>(QualifierNameStack.top()) == "") {
-				return new Var(crd->getNameAsString()); 
-			}	
-		}
-				
-		if (auto* ctd = dyn_cast<ClassTemplateDecl>(d)) {	
-						
-			if(isFromTypeTraits(ctd->getNameAsString())) {
-				std::string traitName = ctd->getNameAsString();
-				
-				if (traitName == std::get<0>(QualifierNameStack.top()) 
-				&& std::get<1>(QualifierNameStack.top()) == "value") {
-					traitName += "::v";				
-					
-					if (QualifierNameStack.size() > 0)
-						QualifierNameStack.pop();
-				}
-								
-				if (traitName == std::get<0>(QualifierNameStack.top())
-				 && std::get<1>(QualifierNameStack.top()) == "type") {
-					traitName += "::t";			
-
-					if (QualifierNameStack.size() > 0)
-						QualifierNameStack.pop();
-				}
-							
-				return new Var(traitName);									
-			}
-											
-			for (auto i = ctd->getTemplatedDecl()->decls_begin(), e = ctd->getTemplatedDecl()->decls_end(); i != e; i++) {
-				CLambda *tCLambdaTop = nullptr, *tCLambdaCurr = nullptr;
-				std::string pVarName = "";
-				
-				for(auto i = ctd->getTemplateParameters()->begin(), e = ctd->getTemplateParameters()->end(); i != e; i++) {	
-					pVarName = ((*i)->isParameterPack()) ? ("..." + (*i)->getNameAsString()) : (*i)->getNameAsString();
-					
-					if (tCLambdaTop == nullptr) {
-						tCLambdaTop = tCLambdaCurr = new CLambda(); 
-						tCLambdaCurr->pat = new PVar(pVarName); 
-					} else {
-						tCLambdaCurr->expr = new CLambda();
-						tCLambdaCurr = dynamic_cast<CLambda*>(tCLambdaCurr->expr); 	
-						tCLambdaCurr->pat = new PVar(pVarName);
-					}
-				}
-
-			   if (auto* nd = dyn_cast<NamedDecl>(*i)) { 				   
-					if (ctd->getNameAsString() == std::get<0>(QualifierNameStack.top())
-					 && nd->getNameAsString() == std::get<1>(QualifierNameStack.top())) {
-						
-						if (QualifierNameStack.size() > 0)
-							QualifierNameStack.pop();
-										
-						tCLambdaCurr->expr = TransformToCExpr(*i);
-						return tCLambdaTop;
-					}
-				}
-			}
-		}
+public:
+    // Only the class templates matter, so skip function bodies and keep
+    // warnings about the rest of the code quiet.
+    bool BeginInvocation(CompilerInstance &CI) override {
+        CI.getFrontendOpts().SkipFunctionBodies = true;
+        CI.getDiagnostics().setIgnoreAllWarnings(true);
+        return true;
+    }
+
+    void EndSourceFileAction() override { // If I wish to print a file out, this would be the place. 
+        if (consumer && consumer->getVisitor().found)
+            foundStruct = true;
+        if (consumer && !consumer->cursorError.empty())
+            CursorError = consumer->cursorError;
+    }
+  
+    virtual std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &CI, StringRef file) {
+        consumer = new PointFreeASTConsumer(&CI, outs()); // pass CI pointer to ASTConsumer
+        consumer->cursorFile = CursorFile;
+        consumer->cursorLine = CursorLine;
+        consumer->cursorColumn = CursorColumn;
+        consumer->getVisitor().targets[ClassName] = TargetMemberName;
+        consumer->getVisitor().withSpecializations = true;
+        consumer->getVisitor().recursionBudget = FixExpansions;
+        consumer->getVisitor().backend = OutputBackend;
+        consumer->getVisitor().verify = Verify;
+        consumer->getVisitor().jsonOutput = JSONOutput;
+        consumer->getVisitor().pipeline = ConversionPipeline.get();
+        consumer->getVisitor().pool = EnginePool.get();
+        consumer->getVisitor().flatPool = FlatPool;
+        consumer->getVisitor().bulk = Bulk;
+        consumer->getVisitor().memo = ResultMemo.get();
+        consumer->getVisitor().limits = Limits;
+        consumer->getVisitor().concurrent = Concurrent;
+        consumer->getVisitor().verificationFailedFlag = &verificationFailed;
+        if (!EmitVerification.empty())
+            consumer->getVisitor().verificationUnit = &Verification;
+        if (!AliasHeader.empty())
+            consumer->getVisitor().aliasDefinitions = &AliasDefinitions;
+        if (!BatchHeaderFile.empty())
+            consumer->getVisitor().batchHeader = &Batch;
+        return std::unique_ptr<PointFreeASTConsumer>(consumer);
+    }
+};
+
+
+
+// Discovery mode, candidates are class templates and their explicit or partial
+// specializations from the main file (so not <type_traits> or Curtains) with
+// a type alias/typedef named type, or a variable or field named value.
+DeclarationMatcher ConvertibleMember = namedDecl(
+	anyOf(typedefNameDecl(hasName("type")),
+	      varDecl(hasName("value"), hasInitializer(expr())),
+	      fieldDecl(hasName("value")))).bind("member");
+
+DeclarationMatcher CandidateTemplate = classTemplateDecl(
+	isExpansionInMainFile(),
+	forEach(cxxRecordDecl(isDefinition(), forEach(ConvertibleMember)))).bind("class");
+
+DeclarationMatcher CandidateSpecialization = classTemplateSpecializationDecl(
+	isExpansionInMainFile(), isExplicitTemplateSpecialization(),
+	forEach(ConvertibleMember)).bind("class");
+
+class DiscoveryCallback : public MatchFinder::MatchCallback {
+private:
+	std::unique_ptr<PointFreeVisitor> visitor;
+
+public:
+	// one visitor per translation unit
+	void onStartOfTranslationUnit() override { visitor.reset(); }
 
-		return nullptr;
+	void onEndOfTranslationUnit() override {
+		if (visitor)
+			visitor->FinishDeferred();
 	}
-	
-	CExpr* TransformToCExpr(const clang::Type* t) {
-		if (auto* pt = dyn_cast<clang::PointerType>(t)) {
-			CExpr* expr = TransformToCExpr(pt->getPointeeType().getTypePtr());
-			
-			App* app = new App();
-			app->exprL = expr;
-			app->exprR = new Var("*"); 
-			expr = app;
-		
-			return expr;
-		}		
-		
-		if (auto* pet = dyn_cast<PackExpansionType>(t)) {			
-			CExpr* expr = TransformToCExpr(pet->getPattern().getTypePtr());
-			
-			if (auto* var = dynamic_cast<Var*>(expr)) 	
-				var->name = "..." + var->name;
-							  
-			return expr; 
-		}
 
-		if (auto* tt = dyn_cast<TypedefType>(t)) {
-			return TransformToCExpr(tt->getDecl());
-		}
-		
-		// could be incorrectly handling this and throwing away 
-		// important information, its of the type something<possiblevalue>::type 
-		if (auto* dnt = dyn_cast<DependentNameType>(t)) {
-			// This retireves the name after ::, so "::" + getName() would
-			// get ::type or so. Setting the variable in this case is so that 
-			// we can tell which member in the template class is getting invoked
-			// so we can search for it specifically and ignore the rest.  
-			if (auto* tst = dyn_cast<TemplateSpecializationType>(dnt->getQualifier()->getAsType())) 
-				QualifierNameStack.push(std::make_pair(tst->getTemplateName().getAsTemplateDecl()->getName(), dnt->getIdentifier()->getName()));	
-			else
-				errs() << "A non-TemplateSpecializationType passed through \n";
-
-			return TransformToCExpr(dnt->getQualifier());
-		} 
-		
-		// a sugared type, things like std::is_polymorphic<T> have a layer of this
-		if (auto* et = dyn_cast<ElaboratedType>(t)) {
-			return TransformToCExpr(et->desugar().getTypePtr());
+	void run(const MatchFinder::MatchResult &Result) override {
+		if (!visitor) {
+			visitor.reset(new PointFreeVisitor(Result.Context, outs()));
+			visitor->qualifyOutput = true;
+			visitor->recursionBudget = FixExpansions;
+			visitor->backend = OutputBackend;
+			visitor->verify = Verify;
+			visitor->jsonOutput = JSONOutput;
+			visitor->pipeline = ConversionPipeline.get();
+			visitor->pool = EnginePool.get();
+			visitor->flatPool = FlatPool;
+			visitor->bulk = Bulk;
+			visitor->memo = ResultMemo.get();
+			visitor->limits = Limits;
+			visitor->concurrent = Concurrent;
+			visitor->verificationFailedFlag = &verificationFailed;
+			if (!EmitVerification.empty())
+				visitor->verificationUnit = &Verification;
+			if (!AliasHeader.empty())
+				visitor->aliasDefinitions = &AliasDefinitions;
+			if (!BatchHeaderFile.empty())
+				visitor->batchHeader = &Batch;
 		}
 
-		if (auto* rt = dyn_cast<RecordType>(t)) {
-			return TransformToCExpr(rt->getDecl());	
-		}
-			
-		if (auto* dtst = dyn_cast<DependentTemplateSpecializationType>(t)) {		
-			return TransformToCExpr(dtst->getQualifier());			
-		}
-					
-		if (auto* sttpt = dyn_cast<SubstTemplateTypeParmType>(t)) {
-			return TransformToCExpr(sttpt->getReplacementType().getTypePtr());
-		}
-					
-		// same as above, possible loss of information. 
-		if (auto* tst = dyn_cast<TemplateSpecializationType>(t)) {
-			App* curApp, * topApp; 
-			curApp = topApp = new App(); 
-
-		    int curArg = 0, argCount = tst->getNumArgs() - 1;
-			std::string name;	
-			for (auto i = tst->end() - 1, e = tst->begin() - 1; i != e; i--) {
-				CExpr* expr = nullptr;
-				
-				if ((*i).getKind() == TemplateArgument::ArgKind::Type) {
-					expr = TransformToCExpr((*i).getAsType().getTypePtr());					
-				}
-				
-				if ((*i).getKind() == TemplateArgument::ArgKind::Expression) {
-					expr = TransformToCExpr((*i).getAsExpr());
-			    }
-				
-				if ((*i).getKind() == TemplateArgument::ArgKind::Template) {							
-					auto* ctd = dyn_cast<ClassTemplateDecl>((*i).getAsTemplate().getAsTemplateDecl());
-					
-					if (ctd != nullptr && 
-						tst->getTemplateName().getAsTemplateDecl()->getName() == "quote_c" && 
-						ctd->isThisDeclarationADefinition()) {
-						QualifierNameStack.push(std::make_pair((*i).getAsTemplate().getAsTemplateDecl()->getName(), "type"));			
-						expr = TransformToCExpr((*i).getAsTemplate().getAsTemplateDecl()); 
-					} else {
-						expr = new Var((*i).getAsTemplate().getAsTemplateDecl()->getName()); 
-					}
-			    }
-
-				if ((*i).getKind() == TemplateArgument::ArgKind::TemplateExpansion) {
-					errs() << "ArgKind::TemplateExpansion unhandled \n";
-			    }
-			    	
-			    if (curArg < argCount) {			
-				    curApp->exprL = new App(); 
-				    curApp->exprR = expr; 		   
-				    curApp = dynamic_cast<App*>(curApp->exprL);
-			    } else {   				   
-				 	if (tst->getTemplateName().getAsTemplateDecl()->getNameAsString() == std::get<0>(QualifierNameStack.top()) 
-						&& std::get<1>(QualifierNameStack.top()) != "") {
-						curApp->exprL = TransformToCExpr(tst->getTemplateName().getAsTemplateDecl());
-					} else {						
-						curApp->exprL = new Var(tst->getTemplateName().getAsTemplateDecl()->getName()); 
-					}
-											
-					curApp->exprR = expr;											
-			    }   
-				
-			   curArg++;
-			}
-						
-			return topApp;
-		}
-		
-		// a template variable like T 
-		if (auto* ttpt = dyn_cast<TemplateTypeParmType>(t)) {
-			return new Var(ttpt->getIdentifier()->getName());
-		}
-	
-		// hard-coded type like Int, float, string		
-		if (auto* bt = dyn_cast<BuiltinType>(t)) {
-			PrintingPolicy pp = PrintingPolicy(LangOptions());
-			pp.adjustForCPlusPlus();
-			return new Var(bt->getNameAsCString(pp));			
-		}
-		
-		return nullptr;
-	} 
-		
-	CExpr* RemoveCurtainsFromCExpr(CExpr* expr) {
-		if (expr == nullptr)
-			return nullptr;
-			
-		//if (Var* var = dynamic_cast<Var*>(expr)) {}
-		
-		if (App* app = dynamic_cast<App*>(expr)) {
-			if (Var* exprL = dynamic_cast<Var*>(app->exprL)) {					
-				// remove quote/quote_c/eval				
-				if (exprL->name == "quote" || exprL->name == "quote_c" || exprL->name == "eval") {
-					// Unsure if this is enough, you can have quotes around Lambdas for instance  
-			 		if (Var* var = dynamic_cast<Var*>(app->exprR)) {
-						var->curtainsWrapper = exprL->name;	
-					}
-				
-					CExpr* temp = RemoveCurtainsFromCExpr(app->exprR);
-				
-					// delete parent node and left node, retain right node. 
-					app->exprR = nullptr; 
-					delete app;	
-					return temp;	
-				}
-			} else {
-				app->exprL = RemoveCurtainsFromCExpr(app->exprL); 
-				app->exprR = RemoveCurtainsFromCExpr(app->exprR);		
-			}
-		}
-	
-		if (CLambda* lambda = dynamic_cast<CLambda*>(expr)) {
-			lambda->expr = RemoveCurtainsFromCExpr(lambda->expr);
-		}
-		
-		return expr;
+		auto* nd = Result.Nodes.getNodeAs<NamedDecl>("class");
+		auto* member = Result.Nodes.getNodeAs<NamedDecl>("member");
+
+		visitor->Convert(const_cast<NamedDecl*>(nd), member->getNameAsString());
+		foundStruct = true;
 	}
-	
-  	std::string ConvertCExprToCurtains(CExpr* expr) {
-		std::string ret = "";
-		
-		if (expr == nullptr)
-			ret += "nullptr error";
-		
-		if (Var* var = dynamic_cast<Var*>(expr)) {				 						
-			if (isFromTypeTraits(var->name)) {
-				std::size_t found = var->name.find_last_of("::");
-				
-				if (found != std::string::npos) { 
-					if (var->name.substr(found+1) == "t") // ::t
-						ret += "quote_c<std::" + var->name.substr(0, found - 1) +">";	
-					else if (var->name.substr(found+1) == "v") // ::v 
-						ret += "unhandled value \n";
-					  
-				} else {
-					ret += "quote<std::" + var->name + ">";			
-				}
-				
-			} else { 		
-				if (isAPrimitiveType(var->name) // is an int, float etc.
-				 || isACombinatorOrPrelude(var->name)) { // part of curtains
-					ret += var->name;	
-				} else {
-					if (var->curtainsWrapper == "quote_c")
-						ret += "quote_c<" + var->name + ">"; 
-					else if (var->curtainsWrapper == "quote")
-						ret += "quote<" + var->name + ">"; 
-					else
-						ret += "quote<" + var->name + ">"; 
-				}			
-			}
-		}
-		
-		if (App* app = dynamic_cast<App*>(expr)) {
-			ret += "eval<" + ConvertCExprToCurtains(app->exprL) + "," + ConvertCExprToCurtains(app->exprR) + ">";
-		}
-	
-		if (dynamic_cast<CLambda*>(expr)) {
-			assert(false);
-		}
-		
-		return ret;
+};
+
+// Hands each class template and specialization it walks over to the
+// discovery matchers.
+class CandidateVisitor : public RecursiveASTVisitor<CandidateVisitor> {
+private:
+	MatchFinder& finder;
+	ASTContext& context;
+
+public:
+	CandidateVisitor(MatchFinder& finder, ASTContext& context) : finder(finder), context(context) {}
+
+	bool VisitClassTemplateDecl(ClassTemplateDecl* ctd) {
+		finder.match(*ctd, context);
+		return true;
 	}
-	
-	std::string ConvertToCurtains(CExpr* expr) {
-		return ConvertCExprToCurtains(expr);
+
+	// partial specializations too
+	bool VisitClassTemplateSpecializationDecl(ClassTemplateSpecializationDecl* ctsd) {
+		finder.match(*ctsd, context);
+		return true;
 	}
-	
+};
+
+// Runs the discovery matchers over the top level declarations of the main
+// file alone, so <type_traits>, Curtains and the other headers are never
+// traversed, rather than over the whole translation unit as MatchFinder's
+// own consumer does.
+class DiscoveryASTConsumer : public ASTConsumer {
+private:
+	DiscoveryCallback callback;
+	MatchFinder finder;
 
 public:
-    explicit PointFreeVisitor(CompilerInstance *CI) 
-      : astContext(&(CI->getASTContext())) // initialize private members
-    {
-        rewriter.setSourceMgr(CI->getSourceManager(), CI->getLangOpts());	
-    }
+	DiscoveryASTConsumer() {
+		finder.addMatcher(CandidateTemplate, &callback);
+		finder.addMatcher(CandidateSpecialization, &callback);
+	}
 
-    // can be used to access the structure as a template declaration
-    // however I imagine this will pick up templated functions as well
-    // as classes. 
-    virtual bool VisitClassTemplateDecl(ClassTemplateDecl* ctd) { 		
-		if (ctd->getNameAsString() == ClassName) {
-			foundStruct = true; 		    	
-			auto topCopy = std::make_pair(std::get<0>(QualifierNameStack.top()), std::get<1>(QualifierNameStack.top()));
-		/*
-		    // Splits calls up and prints more detailed information for debuging
-			std::cout << "\n";
-	    	std::cout << "ClassTemplateDecl Converted To CExpr: \n";
-			CExpr* expr = TransformToCExpr(ctd);	    	
-	    	Print(expr); 
-			std::cout << "\n \n \n Removed Curtains Calls From CExpr: \n";
-	    	expr = RemoveCurtainsFromCExpr(expr);
-			Print(expr); 
-	    	std::cout << "\n \n \nCExpr After Point Free Conversion: \n";
-	    	expr = PointFree(expr);
-			Print(expr);
-	    */
-	  
-	    	std::cout << ConvertToCurtains(PointFree(RemoveCurtainsFromCExpr(TransformToCExpr(ctd)))) << "\n";
-			QualifierNameStack.push(topCopy);
-	    }
-    				         
-        return true;
-    }
-   		
-    virtual bool VisitClassTemplateSpecializationDecl(ClassTemplateSpecializationDecl* ctsd) {
-		if (ctsd->getNameAsString() == ClassName) { 
-			foundStruct = true;
-			auto topCopy = std::make_pair(std::get<0>(QualifierNameStack.top()), std::get<1>(QualifierNameStack.top()));
-	/*
-	        // Splits calls up and prints more detailed information for debuging 
-			std::cout << "\n";
-			CExpr* expr = TransformToCExpr(ctsd);
-	    	std::cout << "ClassTemplateSpecializationDecl Converted To CExpr: \n";
-			Print(expr);
-			std::cout << "\n \n \n Removed Curtains Calls From CExpr: \n";
-			expr = RemoveCurtainsFromCExpr(expr);
-			Print(expr);
-			std::cout << "\n \n \n CExpr After Point Free Conversion: \n";
-	    	expr = PointFree(expr);
-			Print(expr);
-	    	std::cout << "\n \n Curtains Lambda: \n" << ConvertToCurtains(expr) << "\n \n";
-	*/	
-			std::cout << ConvertToCurtains(PointFree(RemoveCurtainsFromCExpr(TransformToCExpr(ctsd)))) << "\n"; 
-			QualifierNameStack.push(topCopy);
+	void HandleTranslationUnit(ASTContext &Context) override {
+		SourceManager& sm = Context.getSourceManager();
+		CandidateVisitor candidates(finder, Context);
+
+		callback.onStartOfTranslationUnit();
+		for (Decl* d : Context.getTranslationUnitDecl()->decls()) {
+			if (sm.isInMainFile(d->getLocation()))
+				candidates.TraverseDecl(d);
 		}
+		callback.onEndOfTranslationUnit();
+	}
+};
 
+class DiscoveryFrontendAction : public ASTFrontendAction {
+public:
+	// as for PointFreeFrontendAction
+	bool BeginInvocation(CompilerInstance &CI) override {
+		CI.getFrontendOpts().SkipFunctionBodies = true;
+		CI.getDiagnostics().setIgnoreAllWarnings(true);
 		return true;
 	}
 
+	std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &CI, StringRef file) override {
+		return llvm::make_unique<DiscoveryASTConsumer>();
+	}
 };
 
+// Whether the text of the source file at path may define a class template
+// named one of names, or any class template when names is empty (for
+// -discover), so that the files which can't are never parsed. The
+// file is only tokenized, by a raw lexer that skips comments and literals,
+// looking for
+//
+//   template <...> struct|class|union ... <name> ... {
+//
+// Nothing is preprocessed, so a class defined in an included header or by
+// a macro is not seen. A file that can't be read is kept, for the parse to
+// report.
+static bool MayDefineClassTemplate(const std::string& path, const std::set<std::string>& names) {
+	ErrorOr<std::unique_ptr<MemoryBuffer>> file = MemoryBuffer::getFile(path);
+	if (!file)
+		return true;
 
-class PointFreeASTConsumer : public ASTConsumer {
-private:
-    PointFreeVisitor *visitor; // doesn't have to be private
+	LangOptions langOpts;
+	langOpts.CPlusPlus = langOpts.CPlusPlus11 = langOpts.CPlusPlus14 = true;
+	langOpts.LineComment = true;
 
-public:
-    // override the constructor in order to pass CI
-    explicit PointFreeASTConsumer(CompilerInstance *CI)
-        : visitor(new PointFreeVisitor(CI)) // initialize the visitor
-    { }
-
-    // override this to call our ExampleVisitor on the entire source file
-    virtual void HandleTranslationUnit(ASTContext &Context) {
-        /* we can use ASTContext to get the TranslationUnitDecl, which is
-             a single Decl that collectively represents the entire source file */
-        visitor->TraverseDecl(Context.getTranslationUnitDecl());
-    }
+	StringRef text = (*file)->getBuffer();
+	Lexer lexer(SourceLocation(), langOpts, text.begin(), text.begin(), text.end());
 
-};
+	// keywords are raw identifiers too
+	auto isWord = [](const Token& token, StringRef word) {
+		return token.is(tok::raw_identifier) && token.getRawIdentifier() == word;
+	};
 
+	Token token;
+	lexer.LexFromRawLexer(token);
 
+	while (token.isNot(tok::eof)) {
+		if (!isWord(token, "template")) {
+			lexer.LexFromRawLexer(token);
+			continue;
+		}
 
-class PointFreeFrontendAction : public ASTFrontendAction {
-public:
-    void EndSourceFileAction() override {} // If I wish to print a file out, this would be the place. 
-  
-    virtual std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &CI, StringRef file) {
-        return std::unique_ptr<PointFreeASTConsumer>(new PointFreeASTConsumer(&CI)); // pass CI pointer to ASTConsumer
-    }
-};
+		lexer.LexFromRawLexer(token);
+		if (token.isNot(tok::less))
+			continue;
+
+		// skip the template parameter list, angle brackets within
+		// parentheses are comparisons
+		int angles = 1, brackets = 0;
+		while (angles > 0 && token.isNot(tok::eof)) {
+			lexer.LexFromRawLexer(token);
+			if (token.isOneOf(tok::l_paren, tok::l_square, tok::l_brace))
+				++brackets;
+			else if (token.isOneOf(tok::r_paren, tok::r_square, tok::r_brace))
+				--brackets;
+			else if (brackets == 0 && token.is(tok::less))
+				++angles;
+			else if (brackets == 0 && token.is(tok::greater))
+				--angles;
+			else if (brackets == 0 && token.is(tok::greatergreater))
+				angles -= 2;
+		}
+		lexer.LexFromRawLexer(token);
+
+		// then the declaration up to its body, a nested template starts over
+		bool classKey = false, named = false;
+		brackets = 0;
+		while (token.isNot(tok::eof) && !isWord(token, "template")) {
+			if (brackets == 0 && token.is(tok::l_brace)) {
+				if (classKey && named)
+					return true;
+				break;
+			}
+			if (brackets == 0 && token.isOneOf(tok::semi, tok::equal))
+				break;
+
+			if (token.isOneOf(tok::l_paren, tok::l_square, tok::l_brace))
+				++brackets;
+			else if (token.isOneOf(tok::r_paren, tok::r_square, tok::r_brace))
+				--brackets;
+			else if (isWord(token, "struct") || isWord(token, "class") || isWord(token, "union"))
+				classKey = true;
+			else if (classKey && token.is(tok::raw_identifier) &&
+			         (names.empty() || names.count(token.getRawIdentifier().str())))
+				named = true;
+
+			lexer.LexFromRawLexer(token);
+		}
+	}
+
+	return false;
+}
+
+// Compiles the verification unit with the compile command of source, minus
+// its input and output, so the unit finds the same headers.
+static int CompileVerification(const CompilationDatabase& db, const std::string& source) {
+	std::vector<CompileCommand> commands = db.getCompileCommands(source);
+	std::string directory = ".";
+	std::vector<std::string> args;
+
+	if (!commands.empty()) {
+		const CompileCommand& command = commands.front();
+		directory = command.Directory;
+
+		for (size_t i = 1; i < command.CommandLine.size(); ++i) {
+			const std::string& arg = command.CommandLine[i];
+			if (arg == "-o")
+				++i;
+			else if (arg != "-c" && arg != command.Filename && arg != source)
+				args.push_back(arg);
+		}
+	}
+
+	FixedCompilationDatabase unitDb(directory, args);
+	ClangTool Tool(unitDb, std::vector<std::string>(1, EmitVerification));
+	int result = Tool.run(newFrontendActionFactory<SyntaxOnlyAction>().get());
 
+	if (result == 0)
+		errs() << "Verified " << Verification.Checks() << " checks \n";
+	return result;
+}
+
+static int WriteHeaders(int result, const CompilationDatabase& db, const std::vector<std::string>& sources) {
+	std::string error;
+	if (!AliasHeader.empty() && !WriteAliasHeader(AliasHeader, AliasDefinitions, error)) {
+		ReportError(error);
+		return 1;
+	}
+	if (!BatchHeaderFile.empty() && !Batch.Write(BatchHeaderFile, error, *OutputBackend)) {
+		ReportError(error);
+		return 1;
+	}
+	if (!MemoFile.empty() && !ResultMemo->Save(MemoFile, error)) {
+		ReportError(error);
+		return 1;
+	}
+
+	if (!EmitVerification.empty()) {
+		// results refer to the aliases of the generated headers
+		if (!AliasHeader.empty())
+			Verification.AddInclude(getAbsolutePath(AliasHeader));
+		if (!BatchHeaderFile.empty())
+			Verification.AddInclude(getAbsolutePath(BatchHeaderFile));
 
+		if (!Verification.Write(EmitVerification, error, *OutputBackend)) {
+			ReportError(error);
+			return 1;
+		}
+
+		if (RunVerification && !sources.empty() && CompileVerification(db, sources.front()) != 0)
+			return 1;
+	}
+
+	if (result == 0 && verificationFailed)
+		return 1;
+	return result;
+}
 
 int main(int argc, const char **argv) {
     // parse the command-line args passed to your code
@@ -644,30 +497,165 @@ int main(int argc, const char **argv) {
    
     MemberName.setCategory(PointFreeCategory);
 	ClassName.setCategory(PointFreeCategory);
+	Discover.setCategory(PointFreeCategory);
+	Prefilter.setCategory(PointFreeCategory);
+	Cursor.setCategory(PointFreeCategory);
+	FixExpansions.setCategory(PointFreeCategory);
+	AliasHeader.setCategory(PointFreeCategory);
+	BatchHeaderFile.setCategory(PointFreeCategory);
+	BackendName.setCategory(PointFreeCategory);
+	Verify.setCategory(PointFreeCategory);
+	Format.setCategory(PointFreeCategory);
+	Pipelined.setCategory(PointFreeCategory);
+	EngineThreads.setCategory(PointFreeCategory);
+	FlatPool.setCategory(PointFreeCategory);
+	Bulk.setCategory(PointFreeCategory);
+	Memo.setCategory(PointFreeCategory);
+	MemoFile.setCategory(PointFreeCategory);
+	MaxNodes.setCategory(PointFreeCategory);
+	MaxOutputBytes.setCategory(PointFreeCategory);
+	TimeoutMs.setCategory(PointFreeCategory);
+	Concurrent.setCategory(PointFreeCategory);
+	EmitVerification.setCategory(PointFreeCategory);
+	RunVerification.setCategory(PointFreeCategory);
     
-    CommonOptionsParser op(argc, argv, PointFreeCategory);        
+    CommonOptionsParser op(argc, argv, PointFreeCategory, cl::ZeroOrMore);        
+
+    OutputBackend = FindBackend(BackendName);
+    if (!OutputBackend) {
+		errs() << "Unknown backend " << BackendName << ", expected one of:";
+		for (const std::string& name : BackendNames())
+			errs() << " " << name;
+		errs() << "\n";
+		return -1;
+	}
+
+    if (Format != "text" && Format != "json") {
+		errs() << "Unknown format " << Format << ", expected text or json\n";
+		return -1;
+	}
+    JSONOutput = (Format == "json");
 
-    if(!ClassName.size()) {
-		errs() << "No structure or class name stated for conversion, exiting without converting \n"; 
+    if (RunVerification && EmitVerification.empty()) {
+		ReportError("-run-verification compiles the -emit-verification unit, give -emit-verification=<file> too");
+		return -1;
+	}
+
+    Limits.maxNodes = MaxNodes;
+    Limits.maxOutputBytes = MaxOutputBytes;
+    Limits.timeoutMs = TimeoutMs;
+
+    if (Pipelined)
+		ConversionPipeline.reset(new Pipeline());
+    if (EngineThreads)
+		EnginePool.reset(new TaskPool(EngineThreads));
+    else if (Concurrent)
+		EnginePool.reset(new TaskPool(std::max(1u, std::thread::hardware_concurrency())));
+
+    if (Memo || !MemoFile.empty()) {
+		ResultMemo.reset(new ConversionMemo());
+		std::string error;
+		if (!MemoFile.empty() && !ResultMemo->Load(MemoFile, error)) {
+			ReportError(error);
+			return -1;
+		}
+	}
+
+    std::vector<std::string> sources = op.getSourcePathList();
+
+    if (Discover) {
+		if (sources.empty())
+			sources = op.getCompilations().getAllFiles();
+
+		if (sources.empty()) {
+			ReportError("No source files given or found in the compilation database");
+			return -1;
+		}
+
+		// only parse the files that may define a class template
+		std::vector<std::string> parsed = sources;
+		if (Prefilter) {
+			std::set<std::string> anyName;
+			parsed.erase(std::remove_if(parsed.begin(), parsed.end(), [&](const std::string& source) {
+				return !MayDefineClassTemplate(source, anyName);
+			}), parsed.end());
+		}
+
+		int result = 0;
+		if (!parsed.empty()) {
+			ClangTool Tool(op.getCompilations(), parsed);
+			result = Tool.run(newFrontendActionFactory<DiscoveryFrontendAction>().get());
+		}
+		if (ConversionPipeline)
+			ConversionPipeline->Finish();
+
+		if (!foundStruct)
+			ReportError("No class templates found for conversion");
+
+		return WriteHeaders(result, op.getCompilations(), sources);
+	}
+
+    if (!Cursor.empty()) {
+		// <file>:<line>:<column>, the file name may itself hold a ':'
+		StringRef rest(Cursor), line, column;
+		std::tie(rest, column) = rest.rsplit(':');
+		std::tie(rest, line) = rest.rsplit(':');
+
+		if (rest.empty() || line.getAsInteger(10, CursorLine) || column.getAsInteger(10, CursorColumn) ||
+		    CursorLine == 0 || CursorColumn == 0) {
+			ReportError("Expected -cursor=<file>:<line>:<column>");
+			return -1;
+		}
+
+		// ClangTool runs in the compile command's directory
+		CursorFile = getAbsolutePath(rest);
+		if (sources.empty())
+			sources.push_back(CursorFile);
+	}
+
+    if (sources.empty() && Prefilter)
+		sources = op.getCompilations().getAllFiles();
+
+    if (sources.empty()) {
+		ReportError(Prefilter ? "No source files given or found in the compilation database" : "No source files given");
+		return -1;
+	}
+
+    if(!ClassName.size() && !CursorLine) {
+		ReportError("No structure or class name stated for conversion, exiting without converting");
 		return -1;
 	}
 	    
-    QualifierNameStack.push(std::make_pair(std::string(""), std::string("")));
     if(!MemberName.size()) {
-		errs() << "Type Alias or TypeDef name not stated, assuming name is: type \n"; 
-		QualifierNameStack.push(std::make_pair(std::string(ClassName), std::string("type")));
+		if (!CursorLine)
+			errs() << "Type Alias or TypeDef name not stated, assuming name is: type \n"; 
+		TargetMemberName = "type";
 	} else {
-		QualifierNameStack.push(std::make_pair(std::string(ClassName), std::string(MemberName)));
+		TargetMemberName = MemberName;
 	}
 
-    // create a new Clang Tool instance (a LibTooling environment)
-    ClangTool Tool(op.getCompilations(), op.getSourcePathList());
+    // only parse the files that may define the class
+    std::vector<std::string> parsed = sources;
+    if (Prefilter && !CursorLine) {
+		std::set<std::string> names = { ClassName };
+		parsed.erase(std::remove_if(parsed.begin(), parsed.end(), [&](const std::string& source) {
+			return !MayDefineClassTemplate(source, names);
+		}), parsed.end());
+	}
 
-    // run the Clang Tool, creating a new FrontendAction (explained below)
-    int result = Tool.run(newFrontendActionFactory<PointFreeFrontendAction>().get());
+    int result = 0;
+    if (!parsed.empty()) {
+		// create a new Clang Tool instance (a LibTooling environment)
+		ClangTool Tool(op.getCompilations(), parsed);
+
+		// run the Clang Tool, creating a new FrontendAction (explained below)
+		result = Tool.run(newFrontendActionFactory<PointFreeFrontendAction>().get());
+	}
+    if (ConversionPipeline)
+		ConversionPipeline->Finish();
       
     if (!foundStruct)
-		errs() << "Could not find requested class or structure for conversion \n";
+		ReportError(CursorError.empty() ? "Could not find requested class or structure for conversion" : CursorError);
       
-    return result;
+    return WriteHeaders(result, op.getCompilations(), sources);
 }
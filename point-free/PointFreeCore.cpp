@@ -0,0 +1,381 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#include "PointFreeCore.h"
+#include "BulkAbstraction.h"
+#include "CommonSubterms.h"
+#include "ExprPool.h"
+#include "LambdaParser.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <sstream>
+
+static CExpr* CountOutput(CExpr* pf, const PointFreeOptions& options) {
+	if (options.stats)
+		options.stats->outputNodes = CountNodes(pf);
+	return pf;
+}
+
+static CExpr* RunPointFree(CExpr* expr, const PointFreeOptions& options, ConversionBudget* budget) {
+	if (options.bulk)
+		return PointFreeBulk(expr, budget);
+	if (options.flatPool)
+		return PointFreeFlat(expr, budget);
+	return PointFree(expr, options.pool, options.memo, budget);
+}
+
+// Discards pf when the budget was overspent, by the engine or by the size
+// of the output, which is only known once pf is written.
+static CExpr* CheckBudget(CExpr* pf, ConversionBudget* budget, const PointFreeOptions& options) {
+	if (budget == nullptr)
+		return pf;
+
+	if (pf && !budget->Exceeded() && options.limits.maxOutputBytes &&
+	    ConvertToBackend(pf, *options.backend).size() > options.limits.maxOutputBytes)
+		budget->Exceed(BudgetLimit::OutputBytes);
+
+	if (options.stats) {
+		options.stats->nodesAllocated = budget->NodesAllocated();
+		options.stats->bytesAllocated = budget->BytesAllocated();
+	}
+	if (options.exceeded)
+		*options.exceeded = budget->Limit();
+
+	if (budget->Limit() != BudgetLimit::None) {
+		delete pf;
+		return nullptr;
+	}
+	return pf;
+}
+
+// Discards pf when the backend can't write it.
+static CExpr* CheckBackend(CExpr* pf, const PointFreeOptions& options) {
+	if (pf == nullptr)
+		return nullptr;
+
+	std::string name = FindUndefinedCombinator(pf, *options.backend);
+	if (name.empty())
+		return pf;
+
+	if (options.undefined)
+		*options.undefined = name;
+	delete pf;
+	return nullptr;
+}
+
+CExpr* ConvertToPointFreeExpr(CExpr* expr, const PointFreeOptions& options) {
+	if (options.exceeded)
+		*options.exceeded = BudgetLimit::None;
+	if (options.undefined)
+		options.undefined->clear();
+
+	if (options.removeCurtains)
+		expr = RemoveCurtainsFromCExpr(expr);
+
+	if (expr == nullptr)
+		return nullptr;
+
+	unsigned inputNodes = 0;
+	if (options.stats || options.limits.Any())
+		inputNodes = CountNodes(expr);
+	if (options.stats)
+		options.stats->inputNodes = inputNodes;
+
+	// the budget's counting is only paid for when it is used
+	std::unique_ptr<ConversionBudget> budget;
+	if (options.stats || options.limits.Any()) {
+		budget.reset(new ConversionBudget(options.limits));
+		if (options.bulk || !options.flatPool)
+			budget->Spend(inputNodes, (sizeof(App) + sizeof(Var)) / 2);
+	}
+
+	if (options.verification == nullptr)
+		return CountOutput(CheckBackend(CheckBudget(RunPointFree(expr, options, budget.get()), budget.get(), options), options), options);
+
+	// the algorithm rewrites '*' before anything else, the input is
+	// compared in that form
+	CExpr* pointful = Clone(expr);
+	ConvertNonTypesToMetafunctions(pointful);
+	Shuffle(pointful);
+
+	CExpr* pf = CheckBackend(CheckBudget(RunPointFree(expr, options, budget.get()), budget.get(), options), options);
+	if (pf)
+		*options.verification = CheckEquivalence(pointful, pf);
+	delete pointful;
+	return CountOutput(pf, options);
+}
+
+void WritePointFree(CExpr* pf, const Backend& backend, std::string& out) {
+	out += ConvertToBackend(pf, backend);
+}
+
+void WritePointFree(CExpr* pf, const Backend& backend, std::string& out, std::string& aliases) {
+	SubtermTable table;
+	unsigned root = table.Add(pf);
+
+	table.Share();
+	aliases += table.Definitions(root, backend);
+
+	CExpr* shared = table.Build(root);
+	out += ConvertToBackend(shared, backend);
+	delete shared;
+}
+
+bool ConvertToPointFree(CExpr* expr, const PointFreeOptions& options, std::string& out) {
+	CExpr* pf = ConvertToPointFreeExpr(expr, options);
+
+	if (pf == nullptr)
+		return false;
+
+	WritePointFree(pf, *options.backend, out);
+	delete pf;
+	return true;
+}
+
+bool ConvertToPointFree(CExpr* expr, const PointFreeOptions& options,
+                        std::string& out, std::string& aliases) {
+	CExpr* pf = ConvertToPointFreeExpr(expr, options);
+
+	if (pf == nullptr)
+		return false;
+
+	WritePointFree(pf, *options.backend, out, aliases);
+	delete pf;
+	return true;
+}
+
+bool ConvertLambdaTerm(const std::string& term, const PointFreeOptions& options,
+                       std::string& out, std::string& error) {
+	CExpr* expr = ParseLambdaTerm(term, error);
+
+	if (expr == nullptr)
+		return false;
+
+	std::string undefined;
+	PointFreeOptions termOptions = options;
+	if (termOptions.undefined == nullptr)
+		termOptions.undefined = &undefined;
+
+	if (!ConvertToPointFree(expr, termOptions, out)) {
+		if (!termOptions.undefined->empty())
+			error = UndefinedCombinatorError(*termOptions.undefined, *options.backend);
+		else
+			error = "term could not be converted";
+		return false;
+	}
+
+	return true;
+}
+
+bool WriteAliasHeader(const std::string& path, const std::string& definitions,
+                      std::string& error) {
+	std::ofstream header(path);
+
+	if (!header) {
+		error = "could not open " + path + " for writing";
+		return false;
+	}
+
+	header << "// Generated by point-free, shared subterms of the converted metafunctions.\n";
+	header << "#pragma once\n\n";
+
+	std::istringstream lines(definitions);
+	std::set<std::string> written;
+	std::string line;
+
+	while (std::getline(lines, line)) {
+		if (written.insert(line).second)
+			header << line << "\n";
+	}
+
+	return true;
+}
+
+bool BatchHeader::Add(const std::string& className, const std::string& memberName,
+                      CExpr* expr, const PointFreeOptions& options, std::string* name) {
+	CExpr* pf = ConvertToPointFreeExpr(expr, options);
+
+	if (pf == nullptr)
+		return false;
+
+	AddPointFree(className, memberName, pf, name);
+	delete pf;
+	return true;
+}
+
+void BatchHeader::AddPointFree(const std::string& className, const std::string& memberName,
+                               CExpr* pf, std::string* name) {
+	std::string alias = className + (memberName == "type" ? "" : "_" + memberName) + "_pf";
+	unsigned count = ++nameCounts[alias];
+	if (count > 1)
+		alias += "_" + std::to_string(count);
+
+	results.push_back(std::make_pair(alias, table.Add(pf)));
+
+	if (name)
+		*name = alias;
+}
+
+std::string BatchHeader::Text(const Backend& backend) {
+	table.Share();
+
+	std::string ret = "// Generated by point-free, the converted metafunctions and their shared subterms.\n";
+	ret += "#pragma once\n";
+	ret += backend.Prelude();
+	ret += "\n";
+	ret += table.Definitions(backend);
+	ret += "\n";
+
+	for (auto& result : results) {
+		// a result that is itself shared refers to its alias
+		std::string body = table.Alias(result.second);
+
+		if (body.empty()) {
+			CExpr* expr = table.Build(result.second);
+			body = ConvertToBackend(expr, backend);
+			delete expr;
+		}
+
+		ret += "using " + result.first + " = " + body + ";\n";
+	}
+
+	return ret;
+}
+
+bool BatchHeader::Write(const std::string& path, std::string& error,
+                        const Backend& backend) {
+	std::ofstream header(path);
+
+	if (!header) {
+		error = "could not open " + path + " for writing";
+		return false;
+	}
+
+	header << Text(backend);
+	return true;
+}
+
+// Types the checks are instantiated with, distinct and, apart from the
+// pointer, free of qualifiers and decorations that some traits would strip.
+static const char* const VerificationArguments[] = {
+	"int", "char", "const double", "long*", "bool", "unsigned short", "float", "void"
+};
+
+static const unsigned VerificationSets = 3;
+
+void VerificationUnit::AddInclude(const std::string& path) {
+	if (std::find(includes.begin(), includes.end(), path) == includes.end())
+		includes.push_back(path);
+}
+
+void VerificationUnit::Add(const std::string& metafunction, const std::string& memberName,
+                           const std::string& result, unsigned arity) {
+	entries.push_back(Entry{metafunction, memberName, result, arity});
+	checks += arity ? VerificationSets : 1;
+}
+
+std::string VerificationUnit::Text(const Backend& backend) {
+	const unsigned pool = sizeof(VerificationArguments) / sizeof(VerificationArguments[0]);
+
+	std::string ret = "// Generated by point-free, checks of the converted metafunctions.\n";
+	ret += "#include <type_traits>\n";
+	ret += backend.Prelude();
+
+	for (const std::string& include : includes)
+		ret += "#include \"" + include + "\"\n";
+	ret += "\n";
+
+	for (const Entry& entry : entries) {
+		std::string label = entry.metafunction + "::" + entry.memberName;
+
+		for (unsigned set = 0; set < (entry.arity ? VerificationSets : 1); ++set) {
+			std::string pointful = entry.metafunction;
+			std::string pointFree = entry.result;
+
+			if (entry.arity) {
+				pointful += "<";
+				for (unsigned i = 0; i < entry.arity; ++i) {
+					// each set starts further into the pool, so the
+					// arguments also differ in their order
+					const char* arg = VerificationArguments[(set * (entry.arity + 1) + i) % pool];
+					pointful += (i ? "," : "") + std::string(arg);
+					pointFree = backend.Apply(pointFree, arg);
+				}
+				pointful += ">";
+			}
+
+			ret += "static_assert(std::is_same<typename " + pointful + "::" + entry.memberName
+			     + ", " + pointFree + ">::value, \"" + label + "\");\n";
+		}
+	}
+
+	return ret;
+}
+
+bool VerificationUnit::Write(const std::string& path, std::string& error,
+                             const Backend& backend) {
+	std::ofstream unit(path);
+
+	if (!unit) {
+		error = "could not open " + path + " for writing";
+		return false;
+	}
+
+	unit << Text(backend);
+	return true;
+}
+
+void JSONRecord::AddKey(const std::string& key) {
+	if (!fields.empty())
+		fields += ",";
+	fields += "\"" + key + "\":";
+}
+
+JSONRecord& JSONRecord::AddString(const std::string& key, const std::string& value) {
+	AddKey(key);
+	fields += "\"";
+
+	for (char c : value) {
+		switch (c) {
+		case '"': fields += "\\\""; break;
+		case '\\': fields += "\\\\"; break;
+		case '\n': fields += "\\n"; break;
+		case '\r': fields += "\\r"; break;
+		case '\t': fields += "\\t"; break;
+		default:
+			if ((unsigned char)c < 0x20) {
+				char escaped[8];
+				snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+				fields += escaped;
+			} else {
+				fields += c;
+			}
+		}
+	}
+
+	fields += "\"";
+	return *this;
+}
+
+JSONRecord& JSONRecord::AddNumber(const std::string& key, uint64_t value) {
+	AddKey(key);
+	fields += std::to_string(value);
+	return *this;
+}
+
+JSONRecord& JSONRecord::AddBool(const std::string& key, bool value) {
+	AddKey(key);
+	fields += value ? "true" : "false";
+	return *this;
+}
+
+const char* EquivalenceName(Equivalence equivalence) {
+	switch (equivalence) {
+	case Equivalence::Equivalent: return "equivalent";
+	case Equivalence::NotEquivalent: return "not-equivalent";
+	case Equivalence::Undecided: return "undecided";
+	}
+	return "";
+}
@@ -0,0 +1,217 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#pragma once
+#include "Backends.h"
+#include "Common.h"
+#include "CommonSubterms.h"
+#include "ConversionBudget.h"
+#include "ConversionMemo.h"
+#include "Reducer.h"
+#include "TaskPool.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////
+/* Point-Free Library Interface 									  */
+////////////////////////////////////////////////////////////////////////
+
+// The pointFreeCore library is the Clang independent half of the tool, the
+// intermediate structure from Common.h, the Point-Free algorithm and the
+// output backends. It keeps no global state, separate conversions can be
+// run from separate threads, each working on its own expression.
+
+struct ConversionStats {
+	// CExpr nodes, counted after removeCurtains and before sharing.
+	unsigned inputNodes = 0;
+	unsigned outputNodes = 0;
+
+	// The IR nodes allocated by the conversion, the input's included, and an
+	// estimate of their bytes, see ConversionBudget. Counted when stats are
+	// asked for.
+	uint64_t nodesAllocated = 0;
+	uint64_t bytesAllocated = 0;
+};
+
+struct PointFreeOptions {
+	// Strip quote, quote_c and eval from the input before conversion, for
+	// expressions extracted from metafunctions that already use Curtains.
+	bool removeCurtains = false;
+
+	// The syntax of the result, see Backends.h.
+	const Backend* backend = &CurtainsBackend();
+
+	// When set, the result is checked against the input by reduction (see
+	// Reducer.h) before it is written, and the outcome is stored here.
+	Equivalence* verification = nullptr;
+
+	// When set, the sizes of the input and result are stored here.
+	ConversionStats* stats = nullptr;
+
+	// When set, large expressions are converted with the pool's threads,
+	// see TaskPool.h. The pool may be shared by concurrent conversions.
+	TaskPool* pool = nullptr;
+
+	// Run the algorithm on a flat ExprPool rather than the CExpr tree, see
+	// ExprPool.h. The result is the same, but very large terms take less
+	// memory and time. The pool above is not used.
+	bool flatPool = false;
+
+	// Remove every binder of a term in one traversal with routing
+	// combinators, see BulkAbstraction.h. The result differs from
+	// PointFree's, and is far smaller for terms of many variables. The
+	// pool, the flat pool and the memo are not used.
+	bool bulk = false;
+
+	// When set, lambda terms that only differ in their variable names are
+	// converted once, see ConversionMemo.h. The memo may be shared by
+	// concurrent conversions. Not used by the flat pool.
+	ConversionMemo* memo = nullptr;
+
+	// Limits on the conversion, see ConversionBudget.h. When one of them is
+	// exceeded the conversion is given up on: nullptr is returned and
+	// exceeded, when set, is set to the limit, so that the caller can keep
+	// the pointful form. The limit is None after any other outcome.
+	ConversionLimits limits;
+	BudgetLimit* exceeded = nullptr;
+
+	// When the result refers to a name from Curtains' prelude that the
+	// backend doesn't define (see Backend::Defines), nullptr is returned
+	// and undefined, when set, is set to the name. It is "" after any
+	// other outcome.
+	std::string* undefined = nullptr;
+};
+
+// Converts expr to its point-free form and appends the backend's syntax for
+// it to out. The expression is consumed. Returns false, leaving out as it
+// was, if expr is nullptr or could not be converted.
+bool ConvertToPointFree(CExpr* expr, const PointFreeOptions& options, std::string& out);
+
+// As above, but subterms that occur more than once in the result are pulled
+// out into type aliases (see CommonSubterms.h) which out refers to, their
+// "using" definitions are appended to aliases.
+bool ConvertToPointFree(CExpr* expr, const PointFreeOptions& options,
+                        std::string& out, std::string& aliases);
+
+// The two halves of ConvertToPointFree, for callers that run the algorithm
+// and write the results at different times. ConvertToPointFreeExpr consumes
+// expr and returns the point-free expression, owned by the caller, or
+// nullptr. WritePointFree appends the backend's syntax for a converted
+// expression, which is not modified, to out, optionally sharing subterms
+// through aliases as above.
+CExpr* ConvertToPointFreeExpr(CExpr* expr, const PointFreeOptions& options);
+void WritePointFree(CExpr* pf, const Backend& backend, std::string& out);
+void WritePointFree(CExpr* pf, const Backend& backend, std::string& out, std::string& aliases);
+
+// Parses a Haskell style lambda term (see LambdaParser.h) and converts it
+// as above, error is set when the term is malformed.
+bool ConvertLambdaTerm(const std::string& term, const PointFreeOptions& options,
+                       std::string& out, std::string& error);
+
+// Writes the alias definitions gathered from any number of conversions to a
+// header, each alias once. Returns false and sets error if it can't.
+bool WriteAliasHeader(const std::string& path, const std::string& definitions,
+                      std::string& error);
+
+// Gathers the results of many conversions into one generated header, where
+// every subterm used more than once, by one result or by several, is an
+// alias written only once. Each result becomes an alias of its own:
+//
+//   using pf_5f0e9c3a1b2d4e68 = eval<compose,quote_c<std::remove_cv>>;
+//   using First_pf = const_;
+//   using RemoveCVPtr_pf = eval<pf_5f0e9c3a1b2d4e68,...>;
+//
+// Shared aliases are ordered by size and content hash, so the header only
+// changes where the converted metafunctions do.
+class BatchHeader {
+public:
+	// Converts expr like ConvertToPointFree, the result is named
+	// <className>_pf, or <className>_<memberName>_pf for members other than
+	// type, with a number added when the name is already taken. When given,
+	// name is set to the name chosen.
+	bool Add(const std::string& className, const std::string& memberName,
+	         CExpr* expr, const PointFreeOptions& options, std::string* name = nullptr);
+
+	// As above for an expression already converted by
+	// ConvertToPointFreeExpr, which is not modified.
+	void AddPointFree(const std::string& className, const std::string& memberName,
+	                  CExpr* pf, std::string* name = nullptr);
+
+	// Returns the header's text, in the syntax of backend.
+	std::string Text(const Backend& backend = CurtainsBackend());
+
+	bool Write(const std::string& path, std::string& error,
+	           const Backend& backend = CurtainsBackend());
+
+private:
+	SubtermTable table;
+	std::vector<std::pair<std::string, unsigned>> results;
+	std::map<std::string, unsigned> nameCounts;
+};
+
+// Gathers a static_assert for each converted metafunction into a single
+// translation unit, so the compiler checks them all while parsing the
+// headers they need only once. Each result is applied to a few sets of
+// arguments and compared against the original:
+//
+//   static_assert(std::is_same<typename Second<int,char>::type,
+//                              eval<eval<eval<const_,id>,int>,char>>::value, "Second::type");
+//
+// The arguments come from a fixed pool of types (int, char, const double,
+// long*, ...), so metafunctions expecting something more particular will
+// make the unit fail to compile rather than report a mismatch.
+class VerificationUnit {
+public:
+	// A file the unit includes, in the order they are added, after
+	// <type_traits> and the backend's prelude. Duplicates are ignored.
+	void AddInclude(const std::string& path);
+
+	// metafunction is the class template's name, or for an explicit
+	// specialization the specialization itself (Foo<int>, arity 0), result
+	// is the point-free form or an alias naming it.
+	void Add(const std::string& metafunction, const std::string& memberName,
+	         const std::string& result, unsigned arity);
+
+	// The number of static_asserts in the unit.
+	unsigned Checks() const { return checks; }
+
+	// Returns the unit's text, applying results the way backend does.
+	std::string Text(const Backend& backend = CurtainsBackend());
+
+	bool Write(const std::string& path, std::string& error,
+	           const Backend& backend = CurtainsBackend());
+
+private:
+	struct Entry {
+		std::string metafunction, memberName, result;
+		unsigned arity;
+	};
+
+	std::vector<std::string> includes;
+	std::vector<Entry> entries;
+	unsigned checks = 0;
+};
+
+// Builds one line of JSON output, an object with its fields in the order
+// they are added, for the -format=json mode of the frontends:
+//
+//   {"class":"Second","member":"type","output":"eval<const_,id>"}
+class JSONRecord {
+public:
+	JSONRecord& AddString(const std::string& key, const std::string& value);
+	JSONRecord& AddNumber(const std::string& key, uint64_t value);
+	JSONRecord& AddBool(const std::string& key, bool value);
+
+	// The object followed by a newline.
+	std::string Line() const { return "{" + fields + "}\n"; }
+
+private:
+	void AddKey(const std::string& key);
+
+	std::string fields;
+};
+
+// The text of an Equivalence, for output.
+const char* EquivalenceName(Equivalence equivalence);
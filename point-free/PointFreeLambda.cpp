@@ -0,0 +1,275 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "LambdaParser.h"
+#include "PointFreeCore.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <iostream>
+
+using namespace llvm;
+
+// A Clang-free frontend to the Point-Free algorithm, it accepts Haskell style
+// lambda terms rather than C++ metafunctions and prints the Curtains (or
+// other -backend) form of each, e.g. "\x y -> x" becomes const_. Terms can
+// be passed on the command line, otherwise they are read one per line from
+// stdin (batch mode) and one line is written to stdout for each of them.
+static cl::OptionCategory PointFreeCategory("Point Free Lambda Options");
+
+static cl::list<std::string> Terms(
+	cl::Positional, cl::ZeroOrMore,
+	cl::desc("[<lambda term> ...]"), cl::cat(PointFreeCategory));
+
+static cl::opt<std::string> AliasHeader(
+	"alias-header", cl::init(""),
+	cl::desc("Replace subterms repeated within an output by aliases, defined in this generated header"),
+	cl::cat(PointFreeCategory));
+
+static cl::opt<std::string> BackendName(
+	"backend", cl::init("curtains"),
+	cl::desc("The metaprogramming library to write results for: curtains, mp11 (Boost.Mp11) or alias (plain C++17 alias templates)"),
+	cl::cat(PointFreeCategory));
+
+static cl::opt<bool> Verify(
+	"verify", cl::init(false),
+	cl::desc("Check every result against its term by reducing both, without compiling anything"),
+	cl::cat(PointFreeCategory));
+
+static cl::opt<std::string> Format(
+	"format", cl::init("text"),
+	cl::desc("How results are written: text, or json for one JSON object per term"),
+	cl::cat(PointFreeCategory));
+
+static cl::opt<unsigned> EngineThreads(
+	"engine-threads", cl::init(0),
+	cl::desc("Worker threads that help convert large terms, 0 converts each term on one thread"),
+	cl::cat(PointFreeCategory));
+
+static cl::opt<bool> FlatPool(
+	"flat-pool", cl::init(false),
+	cl::desc("Convert on a flat expression pool, which is faster for very large terms"),
+	cl::cat(PointFreeCategory));
+
+static cl::opt<bool> Bulk(
+	"bulk", cl::init(false),
+	cl::desc("Remove every variable of a term at once with n-ary combinators, whose result grows linearly with the number of variables"),
+	cl::cat(PointFreeCategory));
+
+static cl::opt<bool> Memo(
+	"memo", cl::init(false),
+	cl::desc("Convert terms that only differ in their variable names once"),
+	cl::cat(PointFreeCategory));
+
+static cl::opt<std::string> MemoFile(
+	"memo-file", cl::init(""),
+	cl::desc("Keep the results of -memo in this file, read at startup and written at exit (implies -memo)"),
+	cl::cat(PointFreeCategory));
+
+static cl::opt<unsigned> MaxNodes(
+	"max-nodes", cl::init(0),
+	cl::desc("Give up on a term, writing it as it was, when its IR grows past this many nodes, 0 for no limit"),
+	cl::cat(PointFreeCategory));
+
+static cl::opt<unsigned> MaxOutputBytes(
+	"max-output-bytes", cl::init(0),
+	cl::desc("Give up on a term, writing it as it was, when its result is longer than this, 0 for no limit"),
+	cl::cat(PointFreeCategory));
+
+static cl::opt<unsigned> TimeoutMs(
+	"timeout-ms", cl::init(0),
+	cl::desc("Give up on a term, writing it as it was, when the engine takes longer than this, 0 for no limit"),
+	cl::cat(PointFreeCategory));
+
+static std::string AliasDefinitions;
+static bool JSONOutput = false;
+static PointFreeOptions Options;
+
+static cl::extrahelp MoreHelp("\nIf no terms are given, terms are read from stdin, one per line. An empty line produces an empty output line, a malformed term produces an empty output line and a diagnostic on stderr. With -format=json empty lines are skipped and a malformed term produces an object with an error field instead. \n");
+
+// One JSON line for a term, carrying what the text output spreads over
+// stdout and stderr.
+static void WriteRecord(const std::string& term, unsigned lineNo, bool converted,
+                        const std::string& out, const std::string& error,
+                        const ConversionStats& stats, Equivalence verification,
+                        BudgetLimit exceeded, uint64_t microseconds) {
+	JSONRecord record;
+	record.AddString("term", term);
+	if (lineNo)
+		record.AddNumber("line", lineNo);
+
+	record.AddBool("converted", converted);
+	if (converted) {
+		record.AddString("output", out);
+		record.AddNumber("outputSize", out.size());
+		record.AddNumber("inputNodes", stats.inputNodes);
+		record.AddNumber("outputNodes", stats.outputNodes);
+	} else {
+		record.AddString("error", error);
+	}
+
+	if (exceeded != BudgetLimit::None) {
+		record.AddString("exceeded", BudgetLimitName(exceeded, Options.limits));
+		record.AddString("fallback", term);
+	}
+	record.AddNumber("nodesAllocated", stats.nodesAllocated);
+	record.AddNumber("bytesAllocated", stats.bytesAllocated);
+
+	record.AddString("backend", Options.backend->Name());
+	if (converted && Verify)
+		record.AddString("verification", EquivalenceName(verification));
+	record.AddNumber("microseconds", microseconds);
+
+	std::cout << record.Line();
+}
+
+static bool ConvertTerm(const std::string& term, unsigned lineNo, std::string& out) {
+	std::string error;
+	out.clear();
+
+	PointFreeOptions options = Options;
+	Equivalence verification = Equivalence::Equivalent;
+	if (Verify)
+		options.verification = &verification;
+
+	BudgetLimit exceeded = BudgetLimit::None;
+	options.exceeded = &exceeded;
+
+	std::string undefined;
+	options.undefined = &undefined;
+
+	ConversionStats stats;
+	if (JSONOutput || Options.limits.Any())
+		options.stats = &stats;
+
+	auto start = std::chrono::steady_clock::now();
+
+	bool converted;
+	if (AliasHeader.empty()) {
+		converted = ConvertLambdaTerm(term, options, out, error);
+	} else {
+		CExpr* expr = ParseLambdaTerm(term, error);
+		converted = expr && ConvertToPointFree(expr, options, out, AliasDefinitions);
+		if (expr && !converted)
+			error = undefined.empty() ? "term could not be converted" : UndefinedCombinatorError(undefined, *Options.backend);
+	}
+
+	if (exceeded != BudgetLimit::None)
+		error = "exceeded " + BudgetLimitName(exceeded, Options.limits);
+
+	if (JSONOutput) {
+		auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - start);
+		WriteRecord(term, lineNo, converted, out, error, stats, verification, exceeded, elapsed.count());
+		return (converted && verification != Equivalence::NotEquivalent) || exceeded != BudgetLimit::None;
+	}
+
+	// given up on, the term is written as it was
+	if (exceeded != BudgetLimit::None) {
+		if (lineNo)
+			errs() << "line " << lineNo << ": ";
+		errs() << error << " after allocating " << stats.nodesAllocated << " IR nodes (about " << stats.bytesAllocated
+		       << " bytes), the term is kept pointful\n";
+		std::cout << term << "\n";
+		return true;
+	}
+
+	if (!converted) {
+		if (lineNo)
+			errs() << "line " << lineNo << ": ";
+		errs() << "could not convert lambda term: " << error << "\n";
+		std::cout << "\n";
+		return false;
+	}
+
+	std::cout << out << "\n";
+
+	if (verification != Equivalence::Equivalent) {
+		if (lineNo)
+			errs() << "line " << lineNo << ": ";
+		if (verification == Equivalence::NotEquivalent) {
+			errs() << "verification failed, " << out << " is not equivalent to " << term << "\n";
+			return false;
+		}
+		errs() << "could not verify " << out << ", the reduction took too long\n";
+	}
+
+	return true;
+}
+
+int main(int argc, const char **argv) {
+	cl::HideUnrelatedOptions(PointFreeCategory);
+	cl::ParseCommandLineOptions(argc, argv, "Point-Free lambda term converter\n");
+
+	Options.backend = FindBackend(BackendName);
+	if (!Options.backend) {
+		errs() << "unknown backend " << BackendName << ", expected one of:";
+		for (const std::string& name : BackendNames())
+			errs() << " " << name;
+		errs() << "\n";
+		return 1;
+	}
+
+	if (Format != "text" && Format != "json") {
+		errs() << "unknown format " << Format << ", expected text or json\n";
+		return 1;
+	}
+	JSONOutput = (Format == "json");
+
+	Options.flatPool = FlatPool;
+	Options.bulk = Bulk;
+	Options.limits.maxNodes = MaxNodes;
+	Options.limits.maxOutputBytes = MaxOutputBytes;
+	Options.limits.timeoutMs = TimeoutMs;
+
+	std::string error;
+	ConversionMemo memo;
+	if (Memo || !MemoFile.empty()) {
+		if (!MemoFile.empty() && !memo.Load(MemoFile, error)) {
+			errs() << error << "\n";
+			return 1;
+		}
+		Options.memo = &memo;
+	}
+
+	std::unique_ptr<TaskPool> pool;
+	if (EngineThreads) {
+		pool.reset(new TaskPool(EngineThreads));
+		Options.pool = pool.get();
+	}
+
+	std::ios::sync_with_stdio(false);
+	std::string out;
+	bool ok = true;
+
+	if (!Terms.empty()) {
+		for (const std::string& term : Terms)
+			ok &= ConvertTerm(term, 0, out);
+	} else {
+		std::string line;
+		unsigned lineNo = 0;
+		while (std::getline(std::cin, line)) {
+			++lineNo;
+			if (line.find_first_not_of(" \t\r") == std::string::npos) {
+				if (!JSONOutput)
+					std::cout << "\n";
+				continue;
+			}
+			ok &= ConvertTerm(line, lineNo, out);
+		}
+	}
+
+	if (!AliasHeader.empty() && !WriteAliasHeader(AliasHeader, AliasDefinitions, error)) {
+		errs() << error << "\n";
+		ok = false;
+	}
+
+	if (!MemoFile.empty() && !memo.Save(MemoFile, error)) {
+		errs() << error << "\n";
+		ok = false;
+	}
+
+	return ok ? 0 : 1;
+}
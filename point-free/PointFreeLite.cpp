@@ -0,0 +1,134 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Frontend/FrontendAction.h"
+#include "clang/Frontend/Utils.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "PointFreeVisitor.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace clang;
+using namespace llvm;
+using namespace pointfree;
+
+// A slim form of point-free for converting one class template of one file,
+// for editors and scripts that start a process per conversion. The file is
+// parsed with the compiler flags following "--" by a CompilerInstance of its
+// own rather than through LibTooling, so neither the compilation database,
+// the AST matchers -discover needs, nor clang-format and the rewriters that
+// LibTooling brings along are linked in or initialized at startup:
+//
+//   point-free-lite -classname=First metafunctions.cpp -- -std=c++14
+static cl::OptionCategory PointFreeCategory("Point Free Lite Options");
+
+static cl::opt<std::string> Source(
+	cl::Positional, cl::Required,
+	cl::desc("<source file>"), cl::cat(PointFreeCategory));
+
+static cl::opt<std::string> ClassName(
+	"classname", cl::Required,
+	cl::desc("The template structure or class you wish to be made point free"),
+	cl::cat(PointFreeCategory));
+
+static cl::opt<std::string> MemberName(
+	"membername", cl::init("type"),
+	cl::desc("The name of the using or type alias in the class you wish to convert"),
+	cl::cat(PointFreeCategory));
+
+static cl::opt<unsigned> FixExpansions(
+	"fix-expansions", cl::init(0),
+	cl::desc("How often a recursive metafunction is expanded into itself before the recursion is expressed with fix"),
+	cl::cat(PointFreeCategory));
+
+static cl::opt<std::string> BackendName(
+	"backend", cl::init("curtains"),
+	cl::desc("The metaprogramming library to write results for: curtains, mp11 (Boost.Mp11) or alias (plain C++17 alias templates)"),
+	cl::cat(PointFreeCategory));
+
+static const Backend* OutputBackend = nullptr;
+
+// Its address locates the executable, and so Clang's builtin headers
+// (<stddef.h> and the like) next to it, as LibTooling does.
+static int ResourceAnchor;
+
+class PointFreeLiteAction : public ASTFrontendAction {
+private:
+	PointFreeASTConsumer* consumer = nullptr;
+
+public:
+	bool found = false;
+
+protected:
+	std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &CI, StringRef file) override {
+		consumer = new PointFreeASTConsumer(&CI, outs());
+		consumer->getVisitor().targets[ClassName] = MemberName;
+		consumer->getVisitor().withSpecializations = true;
+		consumer->getVisitor().recursionBudget = FixExpansions;
+		consumer->getVisitor().backend = OutputBackend;
+		return std::unique_ptr<PointFreeASTConsumer>(consumer);
+	}
+
+	void EndSourceFileAction() override {
+		if (consumer && consumer->getVisitor().found)
+			found = true;
+	}
+};
+
+int main(int argc, const char **argv) {
+	// the compiler flags follow "--", as with the LibTooling tools
+	int toolArgc = argc;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--") == 0) {
+			toolArgc = i;
+			break;
+		}
+	}
+
+	cl::HideUnrelatedOptions(PointFreeCategory);
+	cl::ParseCommandLineOptions(toolArgc, argv, "point-free-lite\n");
+
+	OutputBackend = FindBackend(BackendName);
+	if (!OutputBackend) {
+		errs() << "Unknown backend " << BackendName << ", expected one of:";
+		for (const std::string& name : BackendNames())
+			errs() << " " << name;
+		errs() << "\n";
+		return -1;
+	}
+
+	std::string resourceDir = CompilerInvocation::GetResourcesPath(argv[0], &ResourceAnchor);
+	std::vector<const char*> args = { argv[0], "-fsyntax-only", "-resource-dir", resourceDir.c_str() };
+	if (toolArgc < argc)
+		args.insert(args.end(), argv + toolArgc + 1, argv + argc);
+	args.push_back(Source.c_str());
+
+	// the driver reports bad flags itself
+	std::shared_ptr<CompilerInvocation> invocation = createInvocationFromCommandLine(args);
+	if (!invocation)
+		return 1;
+
+	// Only the class templates matter, so skip function bodies and keep
+	// warnings about the rest of the code quiet.
+	invocation->getFrontendOpts().SkipFunctionBodies = true;
+
+	CompilerInstance compiler;
+	compiler.setInvocation(invocation);
+	compiler.createDiagnostics();
+	compiler.getDiagnostics().setIgnoreAllWarnings(true);
+
+	PointFreeLiteAction action;
+	int result = compiler.ExecuteAction(action) ? 0 : 1;
+
+	if (!action.found) {
+		errs() << "Could not find requested class or structure for conversion \n";
+		return 1;
+	}
+
+	return result;
+}
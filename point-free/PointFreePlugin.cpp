@@ -0,0 +1,203 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#include "clang/AST/ASTConsumer.h"
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/FrontendPluginRegistry.h"
+#include "clang/Lex/Preprocessor.h"
+#include "clang/Lex/Pragma.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "PointFreeVisitor.h"
+
+#include <map>
+#include <string>
+
+using namespace clang;
+using namespace llvm;
+using namespace pointfree;
+
+// The point-free tool packaged as a compiler plugin, so that metafunctions
+// are converted while the header they live in is being compiled anyway
+// rather than in a second parse:
+//
+//   clang++ -fplugin=PointFreePlugin.so -c Traits.cpp
+//
+// Class templates to convert are either annotated,
+//
+//   template <class T, class U>
+//   struct [[clang::annotate("pointfree")]] First { using type = T; };
+//
+// ("pointfree:<member>" selects a member other than type), or listed with
+//
+//   #pragma pointfree First [member]
+//
+// Results are written as "<class>::<member> = <MFC>" lines to a side file,
+// named by "-plugin-arg-point-free -plugin-arg-point-free out=<file>", or
+// else the object file (or the main file without one) with ".pointfree"
+// appended. Nothing is written when no class was converted. The arguments
+// "fix-expansions=<n>", "backend=<name>", "verify", "max-nodes=<n>",
+// "max-output-bytes=<n>" and "timeout-ms=<n>" work like the tool's options
+// of the same names, a result that fails verification is reported as a
+// warning.
+
+namespace {
+
+// #pragma pointfree <class> [member]
+class PointFreePragmaHandler : public PragmaHandler {
+private:
+	std::map<std::string, std::string>& targets;
+
+public:
+	PointFreePragmaHandler(std::map<std::string, std::string>& t)
+		: PragmaHandler("pointfree"), targets(t) {}
+
+	void HandlePragma(Preprocessor &PP, PragmaIntroducerKind Introducer, Token &PragmaTok) override {
+		Token tok;
+		PP.LexUnexpandedToken(tok);
+
+		if (tok.isNot(tok::identifier)) {
+			DiagnosticsEngine &D = PP.getDiagnostics();
+			D.Report(tok.getLocation(), D.getCustomDiagID(DiagnosticsEngine::Warning,
+				"expected a class name after '#pragma pointfree', ignoring pragma"));
+			return;
+		}
+
+		std::string className = tok.getIdentifierInfo()->getName();
+		std::string memberName = "type";
+
+		PP.LexUnexpandedToken(tok);
+		if (tok.is(tok::identifier)) {
+			memberName = tok.getIdentifierInfo()->getName();
+			PP.LexUnexpandedToken(tok);
+		}
+
+		if (tok.isNot(tok::eod)) {
+			DiagnosticsEngine &D = PP.getDiagnostics();
+			D.Report(tok.getLocation(), D.getCustomDiagID(DiagnosticsEngine::Warning,
+				"extra tokens at end of '#pragma pointfree'"));
+			PP.DiscardUntilEndOfDirective();
+		}
+
+		targets[className] = memberName;
+	}
+};
+
+class PointFreePluginConsumer : public ASTConsumer {
+private:
+	CompilerInstance &CI;
+	std::string outputPath;
+	std::string results;
+	raw_string_ostream resultStream;
+	PointFreeASTConsumer consumer;
+
+public:
+	PointFreePluginConsumer(CompilerInstance &ci, const std::string& path, unsigned fixExpansions,
+	                        const Backend* backend, bool verify, const ConversionLimits& limits)
+		: CI(ci), outputPath(path), resultStream(results), consumer(&ci, resultStream) {
+		consumer.getVisitor().convertAnnotated = true;
+		consumer.getVisitor().qualifyOutput = true;
+		consumer.getVisitor().recursionBudget = fixExpansions;
+		consumer.getVisitor().backend = backend;
+		consumer.getVisitor().verify = verify;
+		consumer.getVisitor().limits = limits;
+	}
+
+	std::map<std::string, std::string>& getTargets() { return consumer.getVisitor().targets; }
+
+	void HandleTranslationUnit(ASTContext &Context) override {
+		// conversion errors have nothing to work from
+		if (Context.getDiagnostics().hasErrorOccurred())
+			return;
+
+		consumer.HandleTranslationUnit(Context);
+
+		if (!consumer.getVisitor().found)
+			return;
+
+		if (consumer.getVisitor().verificationFailed) {
+			DiagnosticsEngine &D = CI.getDiagnostics();
+			D.Report(D.getCustomDiagID(DiagnosticsEngine::Warning,
+				"point-free: a result is not equivalent to its metafunction"));
+		}
+
+		std::error_code EC;
+		raw_fd_ostream os(outputPath, EC, sys::fs::F_Text);
+
+		if (EC) {
+			DiagnosticsEngine &D = CI.getDiagnostics();
+			D.Report(D.getCustomDiagID(DiagnosticsEngine::Warning,
+				"point-free: could not write '%0': %1")) << outputPath << EC.message();
+			return;
+		}
+
+		os << resultStream.str();
+	}
+};
+
+class PointFreePluginAction : public PluginASTAction {
+private:
+	std::string outputPath;
+	unsigned fixExpansions = 0;
+	const Backend* backend = &CurtainsBackend();
+	bool verify = false;
+	ConversionLimits limits;
+
+protected:
+	std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &CI, StringRef file) override {
+		std::string path = outputPath;
+
+		if (path.empty()) {
+			const std::string& object = CI.getFrontendOpts().OutputFile;
+			path = (object.empty() || object == "-") ? file.str() : object;
+			path += ".pointfree";
+		}
+
+		auto consumer = llvm::make_unique<PointFreePluginConsumer>(CI, path, fixExpansions, backend, verify, limits);
+
+		// the preprocessor owns the handler, it sees the pragmas while the
+		// consumer's visitor is still waiting for the end of the TU
+		CI.getPreprocessor().AddPragmaHandler(new PointFreePragmaHandler(consumer->getTargets()));
+		return std::move(consumer);
+	}
+
+	bool ParseArgs(const CompilerInstance &CI, const std::vector<std::string> &args) override {
+		for (const std::string& arg : args) {
+			if (StringRef(arg).startswith("out=")) {
+				outputPath = arg.substr(strlen("out="));
+			} else if (arg == "verify") {
+				verify = true;
+			} else if (StringRef(arg).startswith("fix-expansions=")
+			        && !StringRef(arg).substr(strlen("fix-expansions=")).getAsInteger(10, fixExpansions)) {
+				continue;
+			} else if (StringRef(arg).startswith("max-nodes=")
+			        && !StringRef(arg).substr(strlen("max-nodes=")).getAsInteger(10, limits.maxNodes)) {
+				continue;
+			} else if (StringRef(arg).startswith("max-output-bytes=")
+			        && !StringRef(arg).substr(strlen("max-output-bytes=")).getAsInteger(10, limits.maxOutputBytes)) {
+				continue;
+			} else if (StringRef(arg).startswith("timeout-ms=")
+			        && !StringRef(arg).substr(strlen("timeout-ms=")).getAsInteger(10, limits.timeoutMs)) {
+				continue;
+			} else if (StringRef(arg).startswith("backend=")
+			        && (backend = FindBackend(arg.substr(strlen("backend="))))) {
+				continue;
+			} else {
+				DiagnosticsEngine &D = CI.getDiagnostics();
+				D.Report(D.getCustomDiagID(DiagnosticsEngine::Error,
+					"point-free: unknown plugin argument '%0'")) << arg;
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// run alongside the normal compile rather than replacing it
+	ActionType getActionType() override { return AddAfterMainAction; }
+};
+
+} // namespace
+
+static FrontendPluginRegistry::Add<PointFreePluginAction>
+	X("point-free", "convert annotated metafunctions to point-free form");
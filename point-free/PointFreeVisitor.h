@@ -0,0 +1,1331 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#pragma once
+#include "clang/AST/AST.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/ASTConsumer.h"
+#include "clang/AST/Attr.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/AST/Type.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "Pipeline.h"
+#include "PointFreeCore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Shared by the point-free tool and the point-free compiler plugin, the
+// visitor finds the requested class templates and prints the point-free
+// form of each of them. They're kept out of namespace clang so that the
+// plugin's classes can't clash with Clang's own.
+
+namespace pointfree {
+
+using namespace clang;
+
+// A conversion whose IR has been extracted from the AST, with everything
+// needed to finish it without the AST, so that a Pipeline can finish it
+// after the translation unit (and the visitor) is gone, and so that many
+// of them can be run through the engine at once.
+struct ConversionJob {
+	ConversionJob() = default;
+	ConversionJob(const ConversionJob&) = delete;
+	ConversionJob& operator=(const ConversionJob&) = delete;
+	~ConversionJob() { delete expr; delete pf; }
+
+	std::string className, qualifiedName, memberName;
+	CExpr* expr = nullptr; // consumed by RunEngine
+
+	// where the class is declared, file is "" when unknown
+	std::string file;
+	unsigned line = 0, column = 0;
+
+	// the verificationUnit check, when checkable
+	bool checkable = false;
+	std::string metafunction, include;
+	unsigned arity = 0;
+
+	// the metafunction quoted in place of a result given up on for the
+	// limits, "" when that wouldn't be equivalent
+	std::string pointfulName;
+
+	// filled in by RunEngine, pf is nullptr when the conversion failed, and
+	// the quoted metafunction when exceeded isn't None
+	CExpr* pf = nullptr;
+	BudgetLimit exceeded = BudgetLimit::None;
+	std::string undefined; // the name the backend lacks when that's why pf is nullptr
+	ConversionStats stats;
+	Equivalence verification = Equivalence::Equivalent;
+
+	uint64_t microseconds = 0; // extraction and engine
+
+	// where the result goes, see the PointFreeVisitor members of the same names
+	raw_ostream* out = nullptr;
+	const Backend* backend = nullptr;
+	bool qualifyOutput = false;
+	bool jsonOutput = false;
+	bool verify = false;
+	std::string* aliasDefinitions = nullptr;
+	BatchHeader* batchHeader = nullptr;
+	VerificationUnit* verificationUnit = nullptr;
+	bool* verificationFailed = nullptr;
+	TaskPool* pool = nullptr;
+	bool flatPool = false;
+	bool bulk = false;
+	ConversionMemo* memo = nullptr;
+	ConversionLimits limits;
+};
+
+// One JSON line describing a conversion, flushed straight away so the
+// output can be consumed as it is produced.
+static void WriteRecord(const ConversionJob& job, const std::string& result) {
+	JSONRecord record;
+	record.AddString("class", job.qualifiedName);
+	record.AddString("member", job.memberName);
+
+	if (!job.file.empty()) {
+		record.AddString("file", job.file);
+		record.AddNumber("line", job.line);
+		record.AddNumber("column", job.column);
+	}
+
+	// a result given up on is written as the fallback
+	bool exceeded = job.exceeded != BudgetLimit::None;
+	record.AddBool("converted", job.pf != nullptr && !exceeded);
+	if (job.pf && !exceeded) {
+		record.AddString("output", result);
+		record.AddNumber("outputSize", result.size());
+		record.AddNumber("inputNodes", job.stats.inputNodes);
+		record.AddNumber("outputNodes", job.stats.outputNodes);
+	} else if (exceeded) {
+		record.AddString("error", "exceeded " + BudgetLimitName(job.exceeded, job.limits));
+		record.AddString("exceeded", BudgetLimitName(job.exceeded, job.limits));
+		if (job.pf)
+			record.AddString("fallback", result);
+	} else if (!job.undefined.empty()) {
+		record.AddString("error", UndefinedCombinatorError(job.undefined, *job.backend));
+	} else {
+		record.AddString("error", "could not convert");
+	}
+	record.AddNumber("nodesAllocated", job.stats.nodesAllocated);
+	record.AddNumber("bytesAllocated", job.stats.bytesAllocated);
+
+	record.AddString("backend", job.backend->Name());
+	if (job.pf && job.verify && !exceeded)
+		record.AddString("verification", EquivalenceName(job.verification));
+	record.AddNumber("microseconds", job.microseconds);
+
+	*job.out << record.Line();
+	job.out->flush();
+}
+
+static void ReportBudget(const ConversionJob& job) {
+	llvm::errs() << job.className << "::" << job.memberName << " exceeded "
+	             << BudgetLimitName(job.exceeded, job.limits) << " after allocating " << job.stats.nodesAllocated
+	             << " IR nodes (about " << job.stats.bytesAllocated << " bytes), "
+	             << (job.pf ? "the metafunction is kept pointful" : "it could not be converted") << "\n";
+}
+
+static void ReportVerification(const ConversionJob& job) {
+	if (job.verification == Equivalence::NotEquivalent) {
+		llvm::errs() << "Verification failed, the result for " << job.className << "::"
+		             << job.memberName << " is not equivalent to it\n";
+		*job.verificationFailed = true;
+	} else if (job.verification == Equivalence::Undecided) {
+		llvm::errs() << "Could not verify " << job.className << "::" << job.memberName
+		             << ", the reduction took too long\n";
+	}
+}
+
+// Runs the Point-Free algorithm on the job's IR. Touches nothing but the
+// job, so jobs can be run concurrently.
+static void RunEngine(ConversionJob& job) {
+	auto start = std::chrono::steady_clock::now();
+
+	PointFreeOptions options;
+	options.removeCurtains = true;
+	options.backend = job.backend;
+	options.pool = job.pool;
+	options.flatPool = job.flatPool;
+	options.bulk = job.bulk;
+	options.memo = job.memo;
+	options.limits = job.limits;
+	options.exceeded = &job.exceeded;
+	options.undefined = &job.undefined;
+	if (job.verify)
+		options.verification = &job.verification;
+	if (job.jsonOutput || job.limits.Any())
+		options.stats = &job.stats;
+
+	job.pf = ConvertToPointFreeExpr(job.expr, options);
+	job.expr = nullptr;
+
+	// given up on, the metafunction itself is what the result would have
+	// been equivalent to
+	if (job.pf == nullptr && job.exceeded != BudgetLimit::None && !job.pointfulName.empty()) {
+		Var* pointful = new Var(job.pointfulName);
+		pointful->curtainsWrapper = "quote_c";
+		job.pf = pointful;
+	}
+
+	job.microseconds += std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start).count();
+}
+
+// Prints the result of a job RunEngine has been through (or adds it to the
+// batchHeader), jobs have to be written one at a time.
+static void WriteConversion(ConversionJob& job) {
+	bool converted = job.pf != nullptr;
+
+	// in a batch the result is the alias it is written to the header as
+	std::string result;
+	if (converted) {
+		if (job.batchHeader)
+			job.batchHeader->AddPointFree(job.className, job.memberName, job.pf, &result);
+		else if (job.aliasDefinitions)
+			WritePointFree(job.pf, *job.backend, result, *job.aliasDefinitions);
+		else
+			WritePointFree(job.pf, *job.backend, result);
+	}
+
+	if (job.jsonOutput) {
+		WriteRecord(job, result);
+	} else if (job.batchHeader) {
+		if (!converted)
+			llvm::errs() << "Could not convert " << job.className << "::" << job.memberName << "\n";
+	} else {
+		if (job.qualifyOutput)
+			*job.out << job.className << "::" << job.memberName << " = ";
+		*job.out << (converted ? result : "nullptr error") << "\n";
+	}
+
+	if (job.exceeded != BudgetLimit::None && !job.jsonOutput)
+		ReportBudget(job);
+
+	if (!job.undefined.empty() && !job.jsonOutput)
+		llvm::errs() << job.className << "::" << job.memberName << ": "
+		             << UndefinedCombinatorError(job.undefined, *job.backend) << "\n";
+
+	if (!converted)
+		return;
+
+	ReportVerification(job);
+
+	if (job.verificationUnit && job.checkable) {
+		if (!job.include.empty())
+			job.verificationUnit->AddInclude(job.include);
+		job.verificationUnit->Add(job.metafunction, job.memberName, result, job.arity);
+	}
+}
+
+// Finishes jobs in the order given, running the engine on all of them at
+// once when there's a pool.
+static void FinishConversions(const std::vector<std::shared_ptr<ConversionJob>>& jobs, TaskPool* pool) {
+	if (pool)
+		pool->ParallelFor(0, jobs.size(), [&jobs](std::size_t i) { RunEngine(*jobs[i]); });
+	else
+		for (auto& job : jobs)
+			RunEngine(*job);
+
+	for (auto& job : jobs)
+		WriteConversion(*job);
+}
+
+class PointFreeVisitor : public RecursiveASTVisitor<PointFreeVisitor> {
+private:
+    ASTContext *astContext; // used for getting additional AST info
+	raw_ostream& out;
+
+	// The class and member name being searched for, with ("", "") always at
+	// the bottom of the stack. Each entry pushed gets the next id in
+	// qualifierIds, so a translation can tell the entries it was given from
+	// the ones it pushed itself.
+	typedef std::pair<std::string, std::string> Qualifier;
+	std::vector<Qualifier> QualifierNameStack;
+	std::vector<unsigned> qualifierIds;
+	unsigned nextQualifierId = 0;
+
+	// What each TransformDeclToCExpr under way has used of the stack it was
+	// given: the lowest of its entries read and the lowest size it popped
+	// the stack to.
+	struct Translation {
+		unsigned firstId;
+		size_t lowestRead;
+		size_t lowestSize;
+	};
+
+	std::vector<Translation> translations;
+
+	void PushQualifier(const Qualifier& qualifier) {
+		QualifierNameStack.push_back(qualifier);
+		qualifierIds.push_back(nextQualifierId++);
+	}
+
+	void PopQualifier() {
+		QualifierNameStack.pop_back();
+		qualifierIds.pop_back();
+		for (auto& t : translations)
+			t.lowestSize = std::min(t.lowestSize, QualifierNameStack.size());
+	}
+
+	void NoteQualifierRead(size_t index) {
+		for (auto& t : translations)
+			if (qualifierIds[index] < t.firstId)
+				t.lowestRead = std::min(t.lowestRead, index);
+	}
+
+	const Qualifier& TopQualifier() {
+		NoteQualifierRead(QualifierNameStack.size() - 1);
+		return QualifierNameStack.back();
+	}
+
+	// Target class templates converted together with their specializations
+	// so far, with withSpecializations, by canonical declaration.
+	std::set<const ClassTemplateDecl*> resolved;
+
+	// The target names at least one of which has been converted, once
+	// there are as many as targets only the main file is left to search.
+	std::set<std::string> resolvedNames;
+
+	// Conversions held back by concurrent, with where their class is.
+	typedef std::pair<SourceLocation, std::shared_ptr<ConversionJob>> DeferredJob;
+	std::vector<DeferredJob> deferred;
+	
+	CExpr* TransformToCExpr(NestedNameSpecifier* nns) {		
+		if (nns->getKind() == NestedNameSpecifier::SpecifierKind::TypeSpec)
+			return TransformToCExpr(nns->getAsType());
+		
+		if (nns->getKind() == NestedNameSpecifier::SpecifierKind::TypeSpecWithTemplate)
+			return TransformToCExpr(nns->getAsType());
+		
+		if (nns->getKind() == NestedNameSpecifier::SpecifierKind::Identifier
+		||  nns->getKind() == NestedNameSpecifier::SpecifierKind::Global
+		||	nns->getKind() == NestedNameSpecifier::SpecifierKind::Super
+		||	nns->getKind() == NestedNameSpecifier::SpecifierKind::NamespaceAlias
+		||	nns->getKind() == NestedNameSpecifier::SpecifierKind::Namespace)
+			llvm::errs() << "Unhandled NestedNameSpecifier in ForwardNestedNameSpecifier \n"; 
+			
+		return nullptr;	
+	}
+			
+	CExpr* TransformToCExpr(Expr* e) {						 
+		if (auto* dsdre = dyn_cast<DependentScopeDeclRefExpr>(e)) {
+			if (auto* tst = dyn_cast<TemplateSpecializationType>(dsdre->getQualifier()->getAsType())) 
+				PushQualifier(std::make_pair(tst->getTemplateName().getAsTemplateDecl()->getName(), dsdre->getDeclName().getAsString()));	
+			else
+				llvm::errs() << "A non-TemplateSpecializationType passed through \n";
+						 
+			return TransformToCExpr(dsdre->getQualifier());
+		}	
+		
+		if (auto* ueotte = dyn_cast<UnaryExprOrTypeTraitExpr>(e)) {		
+			if (ueotte->getKind() == UnaryExprOrTypeTrait::UETT_SizeOf)
+				return new App(new Var("sizeof"), new Var(ueotte->getTypeOfArgument().getAsString()));
+				
+			if (ueotte->getKind() == UnaryExprOrTypeTrait::UETT_AlignOf)
+				return new App(new Var("alignof"), new Var(ueotte->getTypeOfArgument().getAsString()));
+					
+			if (ueotte->getKind() == UnaryExprOrTypeTrait::UETT_OpenMPRequiredSimdAlign 
+			 || ueotte->getKind() == UnaryExprOrTypeTrait::UETT_VecStep) 
+				llvm::errs() << "Unhandled UnaryExprOrTypeTrait \n";
+		}
+		
+		if (auto* dre = dyn_cast<DeclRefExpr>(e)) {
+			if (dre->hasQualifier())
+				return TransformToCExpr(dre->getQualifier());
+				
+			return new Var(dre->getDecl()->getNameAsString()); 
+		}
+		
+		if (auto* sope = dyn_cast<SizeOfPackExpr>(e)) {
+			return new App(new Var("sizeof..."), new Var("..." + sope->getPack()->getNameAsString()));	
+		}
+		
+		if (auto* cble = dyn_cast<CXXBoolLiteralExpr>(e)) {
+			if (cble->getValue())
+				return new Var("true"); 
+			else 
+				return new Var("false");
+		}
+		
+		if (auto* il = dyn_cast<IntegerLiteral>(e)) {			 
+			return new Var(il->getValue().toString(10, true));					
+		}
+		
+		if (auto* cl = dyn_cast<CharacterLiteral>(e)) {
+			std::string s(1, (char)cl->getValue());
+			return new Var(s);	
+		}
+		
+		return nullptr;	
+	}			
+	
+	// Memoizes TransformDeclToCExpr per TU, so an auxiliary template used in
+	// many places is only translated once. A translation reads the class and
+	// member names on top of the QualifierNameStack when it is reached and
+	// often, after popping those, the ones below, so each stored fragment is
+	// kept with every entry it read, from the lowest up to the top, and is
+	// only replayed on a stack ending in the same entries. The stored
+	// fragments are never modified, callers get clones of them.
+	typedef std::pair<Decl*, Qualifier> DeclKey;
+
+	struct DeclMemo {
+		std::vector<Qualifier> read; // the entries read, the top last
+		CExpr* expr;
+		size_t pops; // entries the translation popped off the QualifierNameStack
+	};
+
+	std::map<Decl*, std::vector<DeclMemo>> declMemo;
+
+	const DeclMemo* FindDeclMemo(Decl* d) {
+		auto it = declMemo.find(d);
+		if (it == declMemo.end())
+			return nullptr;
+
+		for (const DeclMemo& memo : it->second) {
+			if (memo.read.size() <= QualifierNameStack.size()
+			 && std::equal(memo.read.begin(), memo.read.end(),
+			               QualifierNameStack.end() - memo.read.size()))
+				return &memo;
+		}
+		return nullptr;
+	}
+
+	// Translations under way, a key met again before its translation ends
+	// is a recursive metafunction. The reference is expanded again up to
+	// recursionBudget times, after which it becomes a variable that the
+	// outermost translation binds with fix:
+	//   fix (\self -> \T -> ... self T' ...)
+	std::map<DeclKey, unsigned> declsInProgress;
+	std::set<DeclKey> recursiveDecls;
+	unsigned recursiveReferences = 0;
+
+	std::string RecursionVariable(const DeclKey& key) {
+		auto* nd = dyn_cast<NamedDecl>(key.first);
+		return "$self_" + (nd ? nd->getNameAsString() : std::string("")) + "_" + key.second.second;
+	}
+
+	CExpr* TransformToCExpr(Decl* d) {
+		DeclKey key = std::make_pair(d, TopQualifier());
+
+		if (const DeclMemo* memo = FindDeclMemo(d)) {
+			// the entries the translation read, read again by the replay
+			for (size_t i = QualifierNameStack.size() - memo->read.size(); i < QualifierNameStack.size(); ++i)
+				NoteQualifierRead(i);
+			for (size_t i = 0; i < memo->pops && QualifierNameStack.size() > 1; ++i)
+				PopQualifier();
+			return Clone(memo->expr);
+		}
+
+		unsigned& active = declsInProgress[key];
+		if (active > recursionBudget) {
+			recursiveDecls.insert(key);
+			++recursiveReferences;
+
+			// the pop the full translation would have made
+			auto* nd = dyn_cast<NamedDecl>(d);
+			if (nd && QualifierNameStack.size() > 1
+			 && std::get<0>(TopQualifier()) == nd->getNameAsString())
+				PopQualifier();
+
+			return new Var(RecursionVariable(key));
+		}
+
+		// the entries read are kept with the result, some may have been
+		// popped by the end
+		std::vector<Qualifier> given = QualifierNameStack;
+		size_t depth = given.size();
+		unsigned references = recursiveReferences;
+
+		++active;
+		translations.push_back(Translation{nextQualifierId, depth - 1, depth});
+		CExpr* expr = TransformDeclToCExpr(d);
+		Translation translation = translations.back();
+		translations.pop_back();
+		bool outermost = (--active == 0);
+
+		bool closed = (references == recursiveReferences);
+		if (outermost && recursiveDecls.erase(key)) {
+			expr = new App(new Var("fix"), new CLambda(new PVar(RecursionVariable(key)), expr));
+			closed = recursiveDecls.empty();
+		}
+
+		if (outermost)
+			declsInProgress.erase(key);
+
+		// a translation that leaves names of its own behind can't be
+		// replayed by popping, nor can one holding a reference to a
+		// translation that's still going on
+		if (closed && QualifierNameStack.size() == translation.lowestSize) {
+			std::vector<Qualifier> read(given.begin() + translation.lowestRead, given.end());
+			DeclMemo memo{std::move(read), Clone(expr), depth - QualifierNameStack.size()};
+			declMemo[d].push_back(std::move(memo));
+		}
+
+		return expr;
+	}
+
+	CExpr* TransformDeclToCExpr(Decl* d) {
+		if (auto* ctpsd = dyn_cast<ClassTemplatePartialSpecializationDecl>(d)) {			
+			if (isFromTypeTraits(ctpsd->getNameAsString())) {
+				auto traitName = ctpsd->getNameAsString();
+				
+				if (traitName == std::get<0>(TopQualifier()) 
+				&& std::get<1>(TopQualifier()) == "value") {
+					traitName += "::v";				
+					
+					if (QualifierNameStack.size() > 0)
+						PopQualifier();
+				}
+								
+				if (traitName == std::get<0>(TopQualifier())
+				 && std::get<1>(TopQualifier()) == "type") {
+					traitName += "::t";			
+
+					if (QualifierNameStack.size() > 0)
+						PopQualifier();
+				}
+							
+				return new Var(traitName);									
+			}
+			
+			for (auto i = ctpsd->decls_begin(), e = ctpsd->decls_end(); i != e; i++) {					
+				CLambda *tCLambdaTop = nullptr, *tCLambdaCurr = nullptr;
+				std::string pVarName = "";
+				
+				for(auto i = ctpsd->getTemplateParameters()->begin(), e = ctpsd->getTemplateParameters()->end(); i != e; i++) {	
+					pVarName = ((*i)->isParameterPack()) ? ("..." + (*i)->getNameAsString()) : (*i)->getNameAsString();
+					
+					if (tCLambdaTop == nullptr) {
+						tCLambdaTop = tCLambdaCurr = new CLambda(); 
+						tCLambdaCurr->pat = new PVar(pVarName); 
+					} else {
+						tCLambdaCurr->expr = new CLambda();
+						tCLambdaCurr = dynamic_cast<CLambda*>(tCLambdaCurr->expr); 	
+						tCLambdaCurr->pat = new PVar(pVarName);
+					}
+				}
+			   
+			    if (auto* nd = dyn_cast<NamedDecl>(*i)) {
+					if (ctpsd->getNameAsString() == std::get<0>(TopQualifier())
+					 && nd->getNameAsString() == std::get<1>(TopQualifier())) {
+					
+						if (QualifierNameStack.size() > 0)
+							PopQualifier();
+										
+						tCLambdaCurr->expr = TransformToCExpr(*i);
+						return tCLambdaTop;
+					}
+				}
+			}
+				
+			return nullptr;
+		}
+		
+		// I don't treat full specialization as a lambda as technically it has no template parameters 
+		// (they're all fixed/constant arguments) I'm unsure of a case where the specialized arguments 
+		// would have to be treated as lambda parameters 
+		if (auto* ctsd = dyn_cast<ClassTemplateSpecializationDecl>(d)) {
+			if(isFromTypeTraits(ctsd->getNameAsString())) {
+				std::string traitName = ctsd->getNameAsString();
+				
+				if (traitName == std::get<0>(TopQualifier()) 
+				&& std::get<1>(TopQualifier()) == "value") {
+					traitName += "::v";				
+					
+					if (QualifierNameStack.size() > 0)
+						PopQualifier();
+				}
+								
+				if (traitName == std::get<0>(TopQualifier())
+				 && std::get<1>(TopQualifier()) == "type") {
+					traitName += "::t";			
+
+					if (QualifierNameStack.size() > 0)
+						PopQualifier();
+				}
+							
+				return new Var(traitName);									
+			}
+			
+			for (auto i = ctsd->decls_begin(), e = ctsd->decls_end(); i != e; i++) {					
+			    if (auto* nd = dyn_cast<NamedDecl>(*i)) {
+					if (ctsd->getNameAsString() == std::get<0>(TopQualifier())
+					&& nd->getNameAsString() == std::get<1>(TopQualifier())) {
+				
+						if (QualifierNameStack.size() > 0)
+							PopQualifier();
+										
+						return TransformToCExpr(*i);
+					}
+				}
+			}
+		
+			return nullptr;			
+		}
+
+		if (auto* tad = dyn_cast<TypeAliasDecl>(d)) {	
+			return TransformToCExpr(tad->getUnderlyingType().getTypePtr());
+		}	
+
+		if (auto* tatd = dyn_cast<TypeAliasTemplateDecl>(d)) {		
+			if (isFromTypeTraits(tatd->getNameAsString())) {			
+				std::string traitName = tatd->getNameAsString();
+				
+				if (traitName == std::get<0>(TopQualifier()) && std::get<1>(TopQualifier()) == "value") {
+					traitName += "::v";				
+					
+					if (QualifierNameStack.size() > 0)
+						PopQualifier();
+				}
+								
+				if (traitName == std::get<0>(TopQualifier()) && std::get<1>(TopQualifier()) == "type") {
+					traitName += "::t";			
+
+					if (QualifierNameStack.size() > 0)
+						PopQualifier();
+				}
+							
+				return new Var(traitName);									
+			}
+								 
+			return TransformToCExpr(tatd->getTemplatedDecl());
+		}
+		
+		if (auto* td = dyn_cast<TypedefDecl>(d)) {
+			return TransformToCExpr(td->getUnderlyingType().getTypePtr());		
+		}
+	
+		if (auto* vd = dyn_cast<VarDecl>(d)) {
+			if (vd->hasInit())		 
+				return TransformToCExpr(vd->getInit());
+		}
+		
+		if (auto* fd = dyn_cast<FieldDecl>(d)) {
+		  if (fd->hasInClassInitializer())
+			  return TransformToCExpr(fd->getInClassInitializer()); 			
+		}
+			
+		if (auto* crd = dyn_cast<CXXRecordDecl>(d)) { 
+			if (std::get<0>(TopQualifier()) == ""
+			 && std::get<1>(TopQualifier()) == "") {
+				return new Var(crd->getNameAsString()); 
+			}	
+		}
+				
+		if (auto* ctd = dyn_cast<ClassTemplateDecl>(d)) {	
+						
+			if(isFromTypeTraits(ctd->getNameAsString())) {
+				std::string traitName = ctd->getNameAsString();
+				
+				if (traitName == std::get<0>(TopQualifier()) 
+				&& std::get<1>(TopQualifier()) == "value") {
+					traitName += "::v";				
+					
+					if (QualifierNameStack.size() > 0)
+						PopQualifier();
+				}
+								
+				if (traitName == std::get<0>(TopQualifier())
+				 && std::get<1>(TopQualifier()) == "type") {
+					traitName += "::t";			
+
+					if (QualifierNameStack.size() > 0)
+						PopQualifier();
+				}
+							
+				return new Var(traitName);									
+			}
+											
+			for (auto i = ctd->getTemplatedDecl()->decls_begin(), e = ctd->getTemplatedDecl()->decls_end(); i != e; i++) {
+				CLambda *tCLambdaTop = nullptr, *tCLambdaCurr = nullptr;
+				std::string pVarName = "";
+				
+				for(auto i = ctd->getTemplateParameters()->begin(), e = ctd->getTemplateParameters()->end(); i != e; i++) {	
+					pVarName = ((*i)->isParameterPack()) ? ("..." + (*i)->getNameAsString()) : (*i)->getNameAsString();
+					
+					if (tCLambdaTop == nullptr) {
+						tCLambdaTop = tCLambdaCurr = new CLambda(); 
+						tCLambdaCurr->pat = new PVar(pVarName); 
+					} else {
+						tCLambdaCurr->expr = new CLambda();
+						tCLambdaCurr = dynamic_cast<CLambda*>(tCLambdaCurr->expr); 	
+						tCLambdaCurr->pat = new PVar(pVarName);
+					}
+				}
+
+			   if (auto* nd = dyn_cast<NamedDecl>(*i)) { 				   
+					if (ctd->getNameAsString() == std::get<0>(TopQualifier())
+					 && nd->getNameAsString() == std::get<1>(TopQualifier())) {
+						
+						if (QualifierNameStack.size() > 0)
+							PopQualifier();
+										
+						tCLambdaCurr->expr = TransformToCExpr(*i);
+						return tCLambdaTop;
+					}
+				}
+			}
+		}
+
+		return nullptr;
+	}
+	
+	CExpr* TransformToCExpr(const clang::Type* t) {
+		if (auto* pt = dyn_cast<clang::PointerType>(t)) {
+			CExpr* expr = TransformToCExpr(pt->getPointeeType().getTypePtr());
+			
+			App* app = new App();
+			app->exprL = expr;
+			app->exprR = new Var("*"); 
+			expr = app;
+		
+			return expr;
+		}		
+		
+		if (auto* pet = dyn_cast<PackExpansionType>(t)) {			
+			CExpr* expr = TransformToCExpr(pet->getPattern().getTypePtr());
+			
+			if (auto* var = dynamic_cast<Var*>(expr)) 	
+				var->name = "..." + var->name;
+							  
+			return expr; 
+		}
+
+		if (auto* tt = dyn_cast<TypedefType>(t)) {
+			return TransformToCExpr(tt->getDecl());
+		}
+		
+		// could be incorrectly handling this and throwing away 
+		// important information, its of the type something<possiblevalue>::type 
+		if (auto* dnt = dyn_cast<DependentNameType>(t)) {
+			// This retireves the name after ::, so "::" + getName() would
+			// get ::type or so. Setting the variable in this case is so that 
+			// we can tell which member in the template class is getting invoked
+			// so we can search for it specifically and ignore the rest.  
+			if (auto* tst = dyn_cast<TemplateSpecializationType>(dnt->getQualifier()->getAsType())) 
+				PushQualifier(std::make_pair(tst->getTemplateName().getAsTemplateDecl()->getName(), dnt->getIdentifier()->getName()));	
+			else
+				llvm::errs() << "A non-TemplateSpecializationType passed through \n";
+
+			return TransformToCExpr(dnt->getQualifier());
+		} 
+		
+		// a sugared type, things like std::is_polymorphic<T> have a layer of this
+		if (auto* et = dyn_cast<ElaboratedType>(t)) {
+			return TransformToCExpr(et->desugar().getTypePtr());
+		}
+
+		if (auto* rt = dyn_cast<RecordType>(t)) {
+			return TransformToCExpr(rt->getDecl());	
+		}
+			
+		if (auto* dtst = dyn_cast<DependentTemplateSpecializationType>(t)) {		
+			return TransformToCExpr(dtst->getQualifier());			
+		}
+					
+		if (auto* sttpt = dyn_cast<SubstTemplateTypeParmType>(t)) {
+			return TransformToCExpr(sttpt->getReplacementType().getTypePtr());
+		}
+					
+		// same as above, possible loss of information. 
+		if (auto* tst = dyn_cast<TemplateSpecializationType>(t)) {
+			App* curApp, * topApp; 
+			curApp = topApp = new App(); 
+
+		    int curArg = 0, argCount = tst->getNumArgs() - 1;
+			std::string name;	
+			for (auto i = tst->end() - 1, e = tst->begin() - 1; i != e; i--) {
+				CExpr* expr = nullptr;
+				
+				if ((*i).getKind() == TemplateArgument::ArgKind::Type) {
+					expr = TransformToCExpr((*i).getAsType().getTypePtr());					
+				}
+				
+				if ((*i).getKind() == TemplateArgument::ArgKind::Expression) {
+					expr = TransformToCExpr((*i).getAsExpr());
+			    }
+				
+				if ((*i).getKind() == TemplateArgument::ArgKind::Template) {							
+					auto* ctd = dyn_cast<ClassTemplateDecl>((*i).getAsTemplate().getAsTemplateDecl());
+					
+					if (ctd != nullptr && 
+						tst->getTemplateName().getAsTemplateDecl()->getName() == "quote_c" && 
+						ctd->isThisDeclarationADefinition()) {
+						PushQualifier(std::make_pair((*i).getAsTemplate().getAsTemplateDecl()->getName(), "type"));			
+						expr = TransformToCExpr((*i).getAsTemplate().getAsTemplateDecl()); 
+					} else {
+						expr = new Var((*i).getAsTemplate().getAsTemplateDecl()->getName()); 
+					}
+			    }
+
+				if ((*i).getKind() == TemplateArgument::ArgKind::TemplateExpansion) {
+					llvm::errs() << "ArgKind::TemplateExpansion unhandled \n";
+			    }
+			    	
+			    if (curArg < argCount) {			
+				    curApp->exprL = new App(); 
+				    curApp->exprR = expr; 		   
+				    curApp = dynamic_cast<App*>(curApp->exprL);
+			    } else {   				   
+				 	if (tst->getTemplateName().getAsTemplateDecl()->getNameAsString() == std::get<0>(TopQualifier()) 
+						&& std::get<1>(TopQualifier()) != "") {
+						curApp->exprL = TransformToCExpr(tst->getTemplateName().getAsTemplateDecl());
+					} else {						
+						curApp->exprL = new Var(tst->getTemplateName().getAsTemplateDecl()->getName()); 
+					}
+											
+					curApp->exprR = expr;											
+			    }   
+				
+			   curArg++;
+			}
+						
+			return topApp;
+		}
+		
+		// a template variable like T 
+		if (auto* ttpt = dyn_cast<TemplateTypeParmType>(t)) {
+			return new Var(ttpt->getIdentifier()->getName());
+		}
+	
+		// hard-coded type like Int, float, string		
+		if (auto* bt = dyn_cast<BuiltinType>(t)) {
+			PrintingPolicy pp = PrintingPolicy(LangOptions());
+			pp.adjustForCPlusPlus();
+			return new Var(bt->getNameAsCString(pp));			
+		}
+		
+		return nullptr;
+	} 
+		
+	bool IsTarget(NamedDecl* nd, std::string& memberName) {
+		auto it = targets.find(nd->getNameAsString());
+		if (it != targets.end()) {
+			memberName = it->second;
+			return true;
+		}
+
+		if (!convertAnnotated)
+			return false;
+
+		// the attribute of a class template sits on its CXXRecordDecl
+		if (auto* ctd = dyn_cast<ClassTemplateDecl>(nd))
+			nd = ctd->getTemplatedDecl();
+
+		for (auto* aa : nd->specific_attrs<AnnotateAttr>()) {
+			StringRef annotation = aa->getAnnotation();
+
+			if (annotation == "pointfree") {
+				memberName = "type";
+				return true;
+			}
+
+			if (annotation.startswith("pointfree:")) {
+				memberName = annotation.substr(strlen("pointfree:"));
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool Contains(Decl* d, SourceLocation loc) {
+		SourceManager& sm = astContext->getSourceManager();
+		SourceLocation begin = sm.getExpansionLoc(d->getLocStart());
+		SourceLocation end = sm.getExpansionLoc(d->getLocEnd());
+		return !sm.isBeforeInTranslationUnit(loc, begin) && !sm.isBeforeInTranslationUnit(end, loc);
+	}
+
+	// Descends only into the declarations around loc, setting found to the
+	// innermost class template or explicit or partial specialization there
+	// and memberName to the member of it loc is in, if any.
+	void FindClassAt(DeclContext* dc, SourceLocation loc, NamedDecl*& found, std::string& memberName) {
+		for (Decl* d : dc->decls()) {
+			if (!Contains(d, loc))
+				continue;
+
+			if (isa<NamespaceDecl>(d) || isa<LinkageSpecDecl>(d)) {
+				FindClassAt(cast<DeclContext>(d), loc, found, memberName);
+				return;
+			}
+
+			CXXRecordDecl* record = nullptr;
+			NamedDecl* candidate = nullptr;
+
+			if (auto* ctd = dyn_cast<ClassTemplateDecl>(d)) {
+				record = ctd->getTemplatedDecl();
+				candidate = ctd;
+			} else if (auto* ctsd = dyn_cast<ClassTemplateSpecializationDecl>(d)) {
+				if (!ctsd->isExplicitSpecialization())
+					continue;
+				record = ctsd;
+				candidate = ctsd;
+			} else if (auto* rd = dyn_cast<CXXRecordDecl>(d)) {
+				// a class template may be a member of a plain class
+				record = rd;
+			}
+
+			if (record == nullptr || !record->isThisDeclarationADefinition())
+				return;
+
+			if (candidate)
+				found = candidate;
+			FindClassAt(record, loc, found, memberName);
+			if (candidate == nullptr || found != candidate)
+				return;
+
+			for (Decl* member : record->decls()) {
+				if ((isa<TypedefNameDecl>(member) || isa<VarDecl>(member) || isa<FieldDecl>(member)) &&
+				    Contains(member, loc))
+					memberName = cast<NamedDecl>(member)->getNameAsString();
+			}
+			return;
+		}
+	}
+
+public:
+    explicit PointFreeVisitor(ASTContext *context, raw_ostream& os)
+      : astContext(context), out(os) // initialize private members
+    {
+		PushQualifier(std::make_pair(std::string(""), std::string("")));
+    }
+
+    ~PointFreeVisitor() {
+		for (auto& entry : declMemo)
+			for (auto& memo : entry.second)
+				delete memo.expr;
+    }
+
+	// Converts memberName of the class template or specialization d and
+	// prints the result (or adds it to the batchHeader), whether or not d is
+	// one of the targets. With a pipeline only the IR is extracted here, the
+	// rest is done on the pipeline's thread.
+	void Convert(NamedDecl* d, const std::string& memberName) {
+		found = true;
+		PushQualifier(std::make_pair(d->getNameAsString(), memberName));
+	/*
+	    // Splits calls up and prints more detailed information for debuging
+		std::cout << "\n";
+		CExpr* expr = TransformToCExpr(d);
+		std::cout << "Decl Converted To CExpr: \n";
+		Print(expr);
+		std::cout << "\n \n \n Removed Curtains Calls From CExpr: \n";
+		expr = RemoveCurtainsFromCExpr(expr);
+		Print(expr);
+		std::cout << "\n \n \n CExpr After Point Free Conversion: \n";
+		expr = PointFree(expr);
+		Print(expr);
+		std::cout << "\n \n Curtains Lambda: \n" << ConvertToCurtains(expr) << "\n \n";
+	*/
+		auto start = std::chrono::steady_clock::now();
+
+		auto job = std::make_shared<ConversionJob>();
+		job->expr = TransformToCExpr(d);
+
+		while (QualifierNameStack.size() > 1)
+			PopQualifier();
+
+		job->className = d->getNameAsString();
+		job->qualifiedName = d->getQualifiedNameAsString();
+		job->memberName = memberName;
+
+		PresumedLoc loc = astContext->getSourceManager().getPresumedLoc(d->getLocation());
+		if (loc.isValid()) {
+			job->file = loc.getFilename();
+			job->line = loc.getLine();
+			job->column = loc.getColumn();
+		}
+
+		if (verificationUnit)
+			FindVerificationTarget(d, memberName, *job);
+
+		job->out = &out;
+		job->backend = backend;
+		job->qualifyOutput = qualifyOutput;
+		job->jsonOutput = jsonOutput;
+		job->verify = verify;
+		job->aliasDefinitions = aliasDefinitions;
+		job->batchHeader = batchHeader;
+		job->verificationUnit = verificationUnit;
+		job->pool = pool;
+		job->flatPool = flatPool;
+		job->bulk = bulk;
+		job->memo = memo;
+		job->limits = limits;
+		job->pointfulName = PointfulName(d, memberName);
+		job->verificationFailed = verificationFailedFlag ? verificationFailedFlag : &verificationFailed;
+
+		job->microseconds = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - start).count();
+
+		if (concurrent) {
+			deferred.push_back(std::make_pair(d->getLocation(), job));
+			return;
+		}
+
+		if (pipeline) {
+			pipeline->Submit([job] { RunEngine(*job); WriteConversion(*job); });
+		} else {
+			RunEngine(*job);
+			WriteConversion(*job);
+		}
+	}
+
+	// Converts the class template, or explicit or partial specialization,
+	// whose definition loc is in, the innermost one when they are nested.
+	// The member converted is the one loc is in, otherwise the annotated
+	// member, otherwise type. Only the declarations enclosing loc are looked
+	// at, so a host that already holds the AST, an editor for one, gets the
+	// result without another parse or a traversal of the translation unit.
+	// Returns false when loc is in no class template.
+	bool ConvertAt(SourceLocation loc) {
+		NamedDecl* d = nullptr;
+		std::string memberName;
+
+		FindClassAt(astContext->getTranslationUnitDecl(), loc, d, memberName);
+		if (d == nullptr)
+			return false;
+
+		if (memberName.empty() && !IsTarget(d, memberName))
+			memberName = "type";
+
+		Convert(d, memberName);
+		FinishDeferred();
+		return true;
+	}
+
+	// Runs the conversions held back by concurrent, all at once, and writes
+	// them in source order. Called at the end of the translation unit.
+	void FinishDeferred() {
+		if (deferred.empty())
+			return;
+
+		SourceManager& sm = astContext->getSourceManager();
+		std::stable_sort(deferred.begin(), deferred.end(),
+			[&sm](const DeferredJob& a, const DeferredJob& b) {
+				return sm.isBeforeInTranslationUnit(a.first, b.first);
+			});
+
+		std::vector<std::shared_ptr<ConversionJob>> jobs;
+		for (auto& entry : deferred)
+			jobs.push_back(entry.second);
+		deferred.clear();
+
+		if (pipeline) {
+			TaskPool* jobPool = pool;
+			pipeline->Submit([jobs, jobPool] { FinishConversions(jobs, jobPool); });
+		} else {
+			FinishConversions(jobs, pool);
+		}
+	}
+
+	// The name to quote in place of d's result when it is given up on, for
+	// primary templates taking types, when the member is type. "" otherwise,
+	// no quoted metafunction is equivalent to the result.
+	std::string PointfulName(NamedDecl* d, const std::string& memberName) {
+		auto* ctd = dyn_cast<ClassTemplateDecl>(d);
+		if (ctd == nullptr || memberName != "type")
+			return "";
+
+		for (NamedDecl* param : *ctd->getTemplateParameters()) {
+			if (!isa<TemplateTypeParmDecl>(param))
+				return "";
+		}
+
+		return ctd->getQualifiedNameAsString();
+	}
+
+	// Sets up the check of d's result in the verificationUnit, for primary
+	// templates with type parameters only and for explicit specializations,
+	// when the member is a type. Partial specializations and packs are left
+	// out, the arguments they'd need can't be taken from a fixed pool.
+	void FindVerificationTarget(NamedDecl* d, const std::string& memberName, ConversionJob& job) {
+		CXXRecordDecl* record = nullptr;
+
+		if (auto* ctd = dyn_cast<ClassTemplateDecl>(d)) {
+			for (NamedDecl* param : *ctd->getTemplateParameters()) {
+				if (!isa<TemplateTypeParmDecl>(param) || param->isParameterPack())
+					return;
+			}
+			record = ctd->getTemplatedDecl();
+			job.metafunction = ctd->getQualifiedNameAsString();
+			job.arity = ctd->getTemplateParameters()->size();
+		} else if (auto* ctsd = dyn_cast<ClassTemplateSpecializationDecl>(d)) {
+			if (isa<ClassTemplatePartialSpecializationDecl>(ctsd))
+				return;
+			record = ctsd;
+			job.metafunction = astContext->getTypeDeclType(ctsd).getAsString(astContext->getPrintingPolicy());
+		} else {
+			return;
+		}
+
+		auto members = record->lookup(DeclarationName(&astContext->Idents.get(memberName)));
+		if (members.empty() || !isa<TypedefNameDecl>(members.front()))
+			return;
+
+		SourceManager& sm = astContext->getSourceManager();
+		FileID file = sm.getFileID(sm.getExpansionLoc(d->getLocation()));
+		if (const FileEntry* entry = sm.getFileEntryForID(file)) {
+			StringRef path = entry->tryGetRealPathName();
+			job.include = path.empty() ? entry->getName().str() : path.str();
+		}
+
+		job.checkable = true;
+	}
+
+	// Class name to member name, for every class that should be converted.
+	std::map<std::string, std::string> targets;
+
+	// Also convert classes annotated with [[clang::annotate("pointfree")]],
+	// or "pointfree:<member>" to convert a member other than type.
+	bool convertAnnotated = false;
+
+	// Prefix each result with "<class>::<member> = ".
+	bool qualifyOutput = false;
+
+	// Write a JSON line for each conversion rather than the bare result, in
+	// batch mode as well.
+	bool jsonOutput = false;
+
+	// When set, subterms repeated within a result are replaced by aliases
+	// whose definitions are appended here.
+	std::string* aliasDefinitions = nullptr;
+
+	// When set, results go to this header rather than being printed.
+	BatchHeader* batchHeader = nullptr;
+
+	// When set, a static_assert checking each result is added to it.
+	VerificationUnit* verificationUnit = nullptr;
+
+	// The syntax results are printed in, see Backends.h.
+	const Backend* backend = &CurtainsBackend();
+
+	// Set once any class has been converted.
+	bool found = false;
+
+	// Check each result against its metafunction by reduction, see
+	// Reducer.h, verificationFailed is set when one doesn't match, or
+	// *verificationFailedFlag when given.
+	bool verify = false;
+	bool verificationFailed = false;
+	bool* verificationFailedFlag = nullptr;
+
+	// When set, the engine and output half of each conversion is run on
+	// the pipeline's thread. Everything the results go to then has to
+	// outlive the visitor and must be left alone until Finish.
+	Pipeline* pipeline = nullptr;
+
+	// Threads the engine may use for large metafunctions, see TaskPool.h.
+	TaskPool* pool = nullptr;
+
+	// Run the engine on a flat ExprPool, see ExprPool.h.
+	bool flatPool = false;
+
+	// Remove every binder at once, see BulkAbstraction.h.
+	bool bulk = false;
+
+	// Results shared by every conversion, see ConversionMemo.h, it may be
+	// used from the pipeline's and pool's threads at once.
+	ConversionMemo* memo = nullptr;
+
+	// Limits on each conversion, see ConversionBudget.h. A metafunction
+	// that exceeds them is kept pointful, quoted, where that is equivalent.
+	ConversionLimits limits;
+
+	// Only extract the IR of each class during the traversal, the engine
+	// is run on all of them by FinishDeferred, in parallel when there's a
+	// pool.
+	bool concurrent = false;
+
+	// How many times a recursive metafunction is expanded into itself
+	// before the recursion is expressed with the fix combinator.
+	unsigned recursionBudget = 0;
+
+	// Convert a target's primary template and all of its specializations as
+	// soon as the first declaration of it is seen. Every class template of
+	// the name in the main file is still found, templates in different
+	// namespaces may share it. Headers are skipped as in TraverseDecl. Only
+	// for use with targets.
+	bool withSpecializations = false;
+
+	// Converts the definitions of ctd and of its explicit and partial
+	// specializations, in the order they appear in the source.
+	void ConvertWithSpecializations(ClassTemplateDecl* ctd, const std::string& memberName) {
+		std::vector<NamedDecl*> decls;
+
+		if (CXXRecordDecl* def = ctd->getTemplatedDecl()->getDefinition())
+			decls.push_back(def->getDescribedClassTemplate());
+
+		for (auto* spec : ctd->specializations()) {
+			if (spec->isExplicitSpecialization() && spec->getDefinition())
+				decls.push_back(cast<ClassTemplateSpecializationDecl>(spec->getDefinition()));
+		}
+
+		SmallVector<ClassTemplatePartialSpecializationDecl*, 4> partials;
+		ctd->getPartialSpecializations(partials);
+		for (auto* partial : partials) {
+			if (partial->getDefinition())
+				decls.push_back(partial);
+		}
+
+		SourceManager& sm = astContext->getSourceManager();
+		std::sort(decls.begin(), decls.end(), [&sm](NamedDecl* a, NamedDecl* b) {
+			return sm.isBeforeInTranslationUnit(a->getLocation(), b->getLocation());
+		});
+
+		for (auto* d : decls)
+			Convert(d, memberName);
+	}
+
+    // can be used to access the structure as a template declaration
+    // however I imagine this will pick up templated functions as well
+    // as classes. 
+    virtual bool VisitClassTemplateDecl(ClassTemplateDecl* ctd) { 		
+		std::string memberName;
+		if (!IsTarget(ctd, memberName))
+			return true;
+
+		if (!withSpecializations) {
+			Convert(ctd, memberName);
+			return true;
+		}
+
+		if (resolved.insert(ctd->getCanonicalDecl()).second) {
+			ConvertWithSpecializations(ctd, memberName);
+			resolvedNames.insert(ctd->getNameAsString());
+		}
+
+		return true;
+    }
+
+	// With withSpecializations, the top level declarations of system headers
+	// are never looked in, and once every target name has been converted
+	// those of the other headers aren't either: only the main file may still
+	// hold another template of the same name. The traversal then ends with
+	// the main file's last declaration.
+	bool TraverseDecl(Decl* d) {
+		if (withSpecializations && d && isa<TranslationUnitDecl>(d->getDeclContext())) {
+			SourceManager& sm = astContext->getSourceManager();
+			SourceLocation loc = d->getLocation();
+			if (sm.isInSystemHeader(loc))
+				return true;
+			if (resolvedNames.size() == targets.size() && !sm.isInMainFile(loc))
+				return true;
+		}
+
+		return RecursiveASTVisitor<PointFreeVisitor>::TraverseDecl(d);
+	}
+   		
+    virtual bool VisitClassTemplateSpecializationDecl(ClassTemplateSpecializationDecl* ctsd) {
+		std::string memberName;
+		if (IsTarget(ctsd, memberName) &&
+		    !resolved.count(ctsd->getSpecializedTemplate()->getCanonicalDecl()))
+			Convert(ctsd, memberName);
+
+		return true;
+	}
+
+};
+
+
+class PointFreeASTConsumer : public ASTConsumer {
+private:
+    PointFreeVisitor *visitor; // doesn't have to be private
+
+public:
+    // override the constructor in order to pass CI
+    explicit PointFreeASTConsumer(CompilerInstance *CI, raw_ostream& os)
+        : visitor(new PointFreeVisitor(&CI->getASTContext(), os)) // initialize the visitor
+    { }
+
+    ~PointFreeASTConsumer() { delete visitor; }
+
+    PointFreeVisitor& getVisitor() { return *visitor; }
+
+    // When cursorLine is set, only the class template at this position of
+    // cursorFile is converted, see PointFreeVisitor::ConvertAt.
+    std::string cursorFile;
+    unsigned cursorLine = 0;
+    unsigned cursorColumn = 0;
+
+    // Why nothing was converted at the cursor, "" when something was.
+    std::string cursorError;
+
+    // override this to call our ExampleVisitor on the entire source file
+    virtual void HandleTranslationUnit(ASTContext &Context) {
+        if (cursorLine) {
+            ConvertAtCursor(Context);
+            return;
+        }
+
+        /* we can use ASTContext to get the TranslationUnitDecl, which is
+             a single Decl that collectively represents the entire source file */
+        visitor->TraverseDecl(Context.getTranslationUnitDecl());
+        visitor->FinishDeferred();
+    }
+
+private:
+    void ConvertAtCursor(ASTContext &Context) {
+        std::string position = cursorFile + ":" + std::to_string(cursorLine) + ":" + std::to_string(cursorColumn);
+
+        SourceManager& sm = Context.getSourceManager();
+        const FileEntry* file = sm.getFileManager().getFile(cursorFile);
+        if (file == nullptr) {
+            cursorError = "Could not open " + cursorFile + " for -cursor";
+            return;
+        }
+
+        FileID fileID = sm.translateFile(file);
+        if (fileID.isInvalid()) {
+            cursorError = cursorFile + " is not part of the translation unit";
+            return;
+        }
+
+        // translateFileLineCol moves a position past the end of a line or
+        // of the file back to the end, which may be in another class
+        bool invalid = false;
+        StringRef text = sm.getBufferData(fileID, &invalid);
+        if (invalid) {
+            cursorError = "Could not read " + cursorFile + " for -cursor";
+            return;
+        }
+
+        size_t start = 0;
+        for (unsigned line = 1; line < cursorLine; ++line) {
+            size_t end = text.find('\n', start);
+            if (end == StringRef::npos) {
+                cursorError = "Line " + std::to_string(cursorLine) + " is past the end of " + cursorFile;
+                return;
+            }
+            start = end + 1;
+        }
+
+        size_t length = std::min(text.find('\n', start), text.size()) - start;
+        if (cursorColumn > length + 1) {
+            cursorError = "Column " + std::to_string(cursorColumn) + " is past the end of line "
+                        + std::to_string(cursorLine) + " of " + cursorFile;
+            return;
+        }
+
+        SourceLocation loc = sm.translateFileLineCol(file, cursorLine, cursorColumn);
+        if (loc.isInvalid()) {
+            cursorError = "Invalid position " + position;
+            return;
+        }
+
+        if (!visitor->ConvertAt(loc))
+            cursorError = "No class template at " + position;
+    }
+
+};
+
+} // namespace pointfree
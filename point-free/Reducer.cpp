@@ -0,0 +1,209 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#include "Reducer.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Value;
+struct Env;
+typedef std::shared_ptr<const Value> ValuePtr;
+typedef std::shared_ptr<const Env> EnvPtr;
+
+// The bindings of the lambdas a closure was created under, innermost first.
+struct Env {
+	std::string name;
+	ValuePtr value;
+	EnvPtr next;
+};
+
+// A reduced expression, values are shared rather than copied so that an
+// argument S duplicates is only reduced once.
+struct Value {
+	enum Kind {
+		Symbol,		// name applied to args, which can't be reduced further
+		Combinator,	// name applied to fewer args than it takes
+		Closure		// a lambda, param bound in env when body is reduced
+	};
+
+	Kind kind;
+	std::string name;
+	std::vector<ValuePtr> args;
+
+	std::string param;
+	CExpr* body = nullptr;
+	EnvPtr env;
+};
+
+static unsigned Arity(const std::string& name) {
+	if (name == "id")
+		return 1;
+	if (name == "const_" || name == "dollar")
+		return 2;
+	if (name == "flip" || name == "compose" || name == "S")
+		return 3;
+
+	// the routing combinators of the bulk engine, see BulkAbstraction.h
+	std::string routes;
+	if (isARouteCombinator(name, routes))
+		return routes.size() + 2;
+	return 0;
+}
+
+class Reducer {
+public:
+	explicit Reducer(unsigned budget) : steps(budget) {}
+
+	ValuePtr Eval(CExpr* expr, const EnvPtr& env) {
+		if (!Step())
+			return Opaque();
+
+		if (Var* var = dynamic_cast<Var*>(expr)) {
+			for (const Env* e = env.get(); e; e = e->next.get()) {
+				if (e->name == var->name)
+					return e->value;
+			}
+
+			auto value = std::make_shared<Value>();
+			value->kind = Arity(var->name) ? Value::Combinator : Value::Symbol;
+			value->name = var->name;
+			return value;
+		}
+
+		if (App* app = dynamic_cast<App*>(expr))
+			return Apply(Eval(app->exprL, env), Eval(app->exprR, env));
+
+		if (CLambda* lambda = dynamic_cast<CLambda*>(expr)) {
+			PVar* pVar = dynamic_cast<PVar*>(lambda->pat);
+			if (pVar == nullptr)
+				return Opaque();
+
+			auto value = std::make_shared<Value>();
+			value->kind = Value::Closure;
+			value->param = pVar->name;
+			value->body = lambda->expr;
+			value->env = env;
+			return value;
+		}
+
+		return Opaque();
+	}
+
+	ValuePtr Apply(const ValuePtr& f, const ValuePtr& x) {
+		if (!Step())
+			return Opaque();
+
+		if (f->kind == Value::Closure) {
+			auto env = std::make_shared<Env>();
+			env->name = f->param;
+			env->value = x;
+			env->next = f->env;
+			return Eval(f->body, env);
+		}
+
+		if (f->kind == Value::Combinator && f->args.size() + 1 == Arity(f->name))
+			return Contract(f->name, f->args, x);
+
+		auto value = std::make_shared<Value>(*f);
+		value->args.push_back(x);
+		return value;
+	}
+
+	bool Equal(const ValuePtr& a, const ValuePtr& b) {
+		if (!Step())
+			return false;
+
+		// compare functions by what they do with an argument
+		if (a->kind != Value::Symbol || b->kind != Value::Symbol) {
+			ValuePtr arg = Fresh();
+			return Equal(Apply(a, arg), Apply(b, arg));
+		}
+
+		if (a->name != b->name || a->args.size() != b->args.size())
+			return false;
+
+		for (std::size_t i = 0; i < a->args.size(); ++i) {
+			if (!Equal(a->args[i], b->args[i]))
+				return false;
+		}
+
+		return true;
+	}
+
+	bool Exhausted() const { return steps == 0; }
+
+private:
+	ValuePtr Contract(const std::string& name, const std::vector<ValuePtr>& args, const ValuePtr& x) {
+		if (name == "id")
+			return x;
+		if (name == "const_")
+			return args[0];
+		if (name == "dollar")
+			return Apply(args[0], x);
+		if (name == "flip")
+			return Apply(Apply(args[0], x), args[1]);
+		if (name == "compose")
+			return Apply(args[0], Apply(args[1], x));
+		if (name == "S")
+			return Apply(Apply(args[0], x), Apply(args[1], x));
+		return ContractRoute(name, args, x);
+	}
+
+	// args are f, g and all but the last of the variables routed, which is
+	// x.
+	ValuePtr ContractRoute(const std::string& name, const std::vector<ValuePtr>& args, const ValuePtr& x) {
+		std::string routes;
+		isARouteCombinator(name, routes);
+
+		ValuePtr f = args[0], g = args[1];
+		for (std::size_t i = 0; i < routes.size(); ++i) {
+			const ValuePtr& var = i + 2 < args.size() ? args[i + 2] : x;
+			if (routes[i] != 'g')
+				f = Apply(f, var);
+			if (routes[i] != 'f')
+				g = Apply(g, var);
+		}
+		return Apply(f, g);
+	}
+
+	// A symbol no expression can refer to, standing for an argument.
+	ValuePtr Fresh() {
+		auto value = std::make_shared<Value>();
+		value->kind = Value::Symbol;
+		value->name = "%" + std::to_string(fresh++);
+		return value;
+	}
+
+	// Stands in for whatever could not be reduced, the result is decided by
+	// Exhausted() or, for malformed input, never equal to anything else.
+	ValuePtr Opaque() {
+		return Fresh();
+	}
+
+	bool Step() {
+		if (steps == 0)
+			return false;
+		--steps;
+		return true;
+	}
+
+	unsigned steps;
+	unsigned fresh = 0;
+};
+
+} // namespace
+
+Equivalence CheckEquivalence(CExpr* pointful, CExpr* pointFree, unsigned stepBudget) {
+	if (pointful == nullptr || pointFree == nullptr)
+		return Equivalence::NotEquivalent;
+
+	Reducer reducer(stepBudget);
+	bool equal = reducer.Equal(reducer.Eval(pointful, nullptr), reducer.Eval(pointFree, nullptr));
+
+	if (reducer.Exhausted())
+		return Equivalence::Undecided;
+
+	return equal ? Equivalence::Equivalent : Equivalence::NotEquivalent;
+}
@@ -0,0 +1,31 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#pragma once
+#include "Common.h"
+
+////////////////////////////////////////////////////////////////////////
+/* Combinator Reduction 											  */
+////////////////////////////////////////////////////////////////////////
+
+// Checks a point-free result against the pointful expression it came from
+// without a compiler. Both are applied to the same fresh symbolic arguments
+// and reduced, using the rules of the combinators the algorithm produces:
+//
+//   id x = x              const_ x y = x        dollar f x = f x
+//   flip f x y = f y x    compose f g x = f (g x)
+//   S f g x = f x (g x)
+//
+// Any other name is an opaque symbol, two results match when they are the
+// same symbol applied to matching arguments. A partially applied combinator
+// or a lambda is compared by applying both sides to one more fresh argument.
+// fix is never unfolded, fix F and fix G match when F and G do.
+enum class Equivalence {
+	Equivalent,
+	NotEquivalent,
+	// the reduction ran out of steps before it could decide
+	Undecided
+};
+
+// Neither expression is modified. The pointful expression is expected as
+// the algorithm sees it, after RemoveCurtainsFromCExpr and the rewriting
+// of '*' done by ConvertNonTypesToMetafunctions and Shuffle.
+Equivalence CheckEquivalence(CExpr* pointful, CExpr* pointFree, unsigned stepBudget = 100000);
@@ -0,0 +1,123 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#include "TaskPool.h"
+
+namespace {
+
+// The pool and queue of the worker running on this thread, if any.
+thread_local const TaskPool* CurrentPool = nullptr;
+thread_local unsigned CurrentQueue = 0;
+
+} // namespace
+
+TaskPool::TaskPool(unsigned threads) : pending(0) {
+	for (unsigned i = 0; i <= threads; ++i)
+		queues.emplace_back(new Queue());
+
+	for (unsigned i = 0; i < threads; ++i)
+		workers.emplace_back(&TaskPool::Work, this, i);
+}
+
+TaskPool::~TaskPool() {
+	{
+		std::lock_guard<std::mutex> lock(idleMutex);
+		stopping = true;
+	}
+	idle.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+unsigned TaskPool::QueueIndex() const {
+	return CurrentPool == this ? CurrentQueue : queues.size() - 1;
+}
+
+void TaskPool::Fork(const std::function<void()>& a, const std::function<void()>& b) {
+	Task task;
+	task.fn = &b;
+	task.done = false;
+
+	Queue& queue = *queues[QueueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(&task);
+	}
+	{
+		// under the lock, so a worker about to wait can't miss it
+		std::lock_guard<std::mutex> lock(idleMutex);
+		++pending;
+	}
+	idle.notify_one();
+
+	a();
+
+	// b is usually still at the back of the queue and runs here, otherwise
+	// help out until whoever stole it is done
+	while (!task.done.load(std::memory_order_acquire)) {
+		if (Task* next = PopOrSteal(QueueIndex()))
+			Run(next);
+		else
+			std::this_thread::yield();
+	}
+}
+
+void TaskPool::ParallelFor(std::size_t begin, std::size_t end,
+                           const std::function<void(std::size_t)>& body) {
+	if (end - begin <= 1) {
+		if (begin < end)
+			body(begin);
+		return;
+	}
+
+	std::size_t middle = begin + (end - begin) / 2;
+	Fork([&] { ParallelFor(begin, middle, body); },
+	     [&] { ParallelFor(middle, end, body); });
+}
+
+TaskPool::Task* TaskPool::PopOrSteal(unsigned index) {
+	{
+		Queue& own = *queues[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty()) {
+			Task* task = own.tasks.back();
+			own.tasks.pop_back();
+			--pending;
+			return task;
+		}
+	}
+
+	for (std::size_t i = 1; i < queues.size(); ++i) {
+		Queue& other = *queues[(index + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(other.mutex);
+		if (!other.tasks.empty()) {
+			Task* task = other.tasks.front();
+			other.tasks.pop_front();
+			--pending;
+			return task;
+		}
+	}
+
+	return nullptr;
+}
+
+void TaskPool::Run(Task* task) {
+	(*task->fn)();
+	task->done.store(true, std::memory_order_release);
+}
+
+void TaskPool::Work(unsigned index) {
+	CurrentPool = this;
+	CurrentQueue = index;
+
+	for (;;) {
+		if (Task* task = PopOrSteal(index)) {
+			Run(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(idleMutex);
+		idle.wait(lock, [this] { return stopping || pending > 0; });
+		if (stopping)
+			return;
+	}
+}
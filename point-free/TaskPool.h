@@ -0,0 +1,62 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////
+/* Work-Stealing Task Pool 											  */
+////////////////////////////////////////////////////////////////////////
+
+// Fork/join parallelism for the Point-Free algorithm, see PointFree(). Each
+// thread has a deque of its own, Fork pushes one half of the work onto the
+// back of it and does the other half itself, idle threads steal from the
+// front of the others' deques. A thread waiting for a stolen half runs
+// other tasks meanwhile, so nested Forks never deadlock. Threads that
+// aren't part of the pool, such as the one calling PointFree, share an
+// extra deque.
+class TaskPool {
+public:
+	// threads workers in addition to the threads calling Fork.
+	explicit TaskPool(unsigned threads);
+	~TaskPool();
+
+	// Runs a and b, possibly at the same time, and returns once both are
+	// done.
+	void Fork(const std::function<void()>& a, const std::function<void()>& b);
+
+	// Runs body(i) for every i in [begin, end), splitting the range with
+	// Fork, and returns once all of them are done.
+	void ParallelFor(std::size_t begin, std::size_t end, const std::function<void(std::size_t)>& body);
+
+private:
+	struct Task {
+		const std::function<void()>* fn;
+		std::atomic<bool> done;
+	};
+
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Task*> tasks;
+	};
+
+	void Work(unsigned index);
+	unsigned QueueIndex() const;
+	Task* PopOrSteal(unsigned index);
+	void Run(Task* task);
+
+	// one queue per worker, then the one shared by outside threads
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> workers;
+
+	std::mutex idleMutex;
+	std::condition_variable idle;
+	std::atomic<unsigned> pending;
+	bool stopping = false;
+};
@@ -0,0 +1,96 @@
+#!/bin/sh
+# Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#
+# Compile-time benchmark of the output backends. Every term in terms.txt is
+# converted with point-free-lambda for each backend, and a translation unit
+# applying each result to INSTANCES distinct sets of arguments is compiled
+# with $CXX -fsyntax-only. The free names in the terms are templates, f
+# taking two arguments and g and h one. The best of REPEAT compiles is
+# reported:
+#
+#   bench/CompileTime.sh build/bin/point-free-lambda
+#
+# The curtains backend is only measured when CURTAINS_INCLUDE names the
+# directory holding Curtains (CURTAINS_HEADER, curtains.hpp by default).
+
+PFL=${1:-point-free-lambda}
+CXX=${CXX:-c++}
+INSTANCES=${INSTANCES:-200}
+REPEAT=${REPEAT:-3}
+HERE=$(cd "$(dirname "$0")" && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+BACKENDS="mp11 alias"
+[ -n "$CURTAINS_INCLUDE" ] && BACKENDS="curtains $BACKENDS"
+
+now_ms() {
+	echo $(($(date +%s%N) / 1000000))
+}
+
+for backend in $BACKENDS; do
+	src="$WORK/$backend.cpp"
+
+	case $backend in
+	curtains)
+		prelude="#include \"${CURTAINS_HEADER:-curtains.hpp}\""
+		apply=eval
+		flags="-I$CURTAINS_INCLUDE" ;;
+	mp11)
+		prelude="#include \"pointfree/mp11.hpp\"
+using namespace pointfree::mp11;"
+		apply=mp_invoke_q
+		flags="-I$HERE/../include" ;;
+	alias)
+		prelude="#include \"pointfree/alias.hpp\"
+using namespace pointfree::alias;"
+		apply=apply
+		flags="-I$HERE/../include" ;;
+	esac
+
+	{
+		echo "#include <type_traits>"
+		echo "#include <utility>"
+		echo "$prelude"
+		echo "template <class, class> struct f {};"
+		echo "template <class> struct g {};"
+		echo "template <class> struct h {};"
+		echo "template <std::size_t> struct arg {};"
+		echo "template <class...> struct all {};"
+	} > "$src"
+
+	n=0
+	while IFS= read -r term; do
+		[ -z "$term" ] && continue
+		result=$("$PFL" -backend="$backend" "$term") || exit 1
+
+		# one argument for each binder of the term, arg<I>, arg<I+1>, ...
+		arity=$(printf "%s\n" "$term" | sed 's/^\\\([^-]*\)->.*/\1/' | wc -w)
+		use="r$n"
+		i=0
+		while [ $i -lt "$arity" ]; do
+			use="$apply<$use,arg<I+$i>>"
+			i=$((i + 1))
+		done
+
+		{
+			echo "using r$n = $result;"
+			echo "template <std::size_t I> using use$n = $use;"
+			echo "template <std::size_t... I> all<use$n<I * $arity>...> run$n(std::index_sequence<I...>);"
+			echo "using out$n = decltype(run$n(std::make_index_sequence<$INSTANCES>{}));"
+		} >> "$src"
+		n=$((n + 1))
+	done < "$HERE/terms.txt"
+
+	best=
+	r=0
+	while [ $r -lt "$REPEAT" ]; do
+		start=$(now_ms)
+		$CXX -std=c++17 -fsyntax-only $flags "$src" || { echo "$backend: compile failed"; best=; break; }
+		elapsed=$(($(now_ms) - start))
+		[ -z "$best" ] || [ "$elapsed" -lt "$best" ] && best=$elapsed
+		r=$((r + 1))
+	done
+
+	[ -n "$best" ] && echo "$backend: $n terms x $INSTANCES instances, ${best} ms"
+done
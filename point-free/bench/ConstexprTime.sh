@@ -0,0 +1,75 @@
+#!/bin/sh
+# Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#
+# Compares converting the terms in terms.txt at compile time, with
+# include/pointfree/constexpr.hpp, against running point-free-lambda on
+# them. Each term is converted COPIES times (as distinct terms, by renaming
+# its free names) so that the cost of conversion stands out from the cost
+# of including the header:
+#
+#   bench/ConstexprTime.sh build/bin/point-free-lambda
+#
+# The compile-time figure is the best of REPEAT compiles with $CXX
+# -fsyntax-only, less the best compile of the header alone. Every compile-time
+# result is checked against the alias backend's output by a static_assert.
+
+PFL=${1:-point-free-lambda}
+CXX=${CXX:-c++}
+COPIES=${COPIES:-20}
+REPEAT=${REPEAT:-3}
+HERE=$(cd "$(dirname "$0")" && pwd)
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+now_ms() {
+	echo $(($(date +%s%N) / 1000000))
+}
+
+# best_compile <source>
+best_compile() {
+	best=
+	r=0
+	while [ $r -lt "$REPEAT" ]; do
+		start=$(now_ms)
+		$CXX -std=c++20 -fsyntax-only -I"$HERE/../include" "$1" || return 1
+		elapsed=$(($(now_ms) - start))
+		[ -z "$best" ] || [ "$elapsed" -lt "$best" ] && best=$elapsed
+		r=$((r + 1))
+	done
+	echo "$best"
+}
+
+echo "#include \"pointfree/constexpr.hpp\"" > "$WORK/empty.cpp"
+cp "$WORK/empty.cpp" "$WORK/constexpr.cpp"
+: > "$WORK/terms.txt"
+
+n=0
+c=0
+while [ $c -lt "$COPIES" ]; do
+	while IFS= read -r term; do
+		[ -z "$term" ] && continue
+		term=$(printf "%s\n" "$term" | sed "s/\([fgh]\)\([ )]\|$\)/\1$c\2/g")
+		printf "%s\n" "$term" >> "$WORK/terms.txt"
+
+		result=$("$PFL" -backend=alias "$term") || exit 1
+		escaped=$(printf "%s" "$term" | sed 's/\\/\\\\/g')
+		printf 'static_assert(pointfree::ct::point_free_string<"%s"> == "%s");\n' "$escaped" "$result" >> "$WORK/constexpr.cpp"
+		n=$((n + 1))
+	done < "$HERE/terms.txt"
+	c=$((c + 1))
+done
+
+base=$(best_compile "$WORK/empty.cpp") || { echo "constexpr: compile failed"; exit 1; }
+total=$(best_compile "$WORK/constexpr.cpp") || { echo "constexpr: compile failed"; exit 1; }
+echo "constexpr: $n terms, $((total - base)) ms (${base} ms for the header alone)"
+
+best=
+r=0
+while [ $r -lt "$REPEAT" ]; do
+	start=$(now_ms)
+	"$PFL" -backend=alias < "$WORK/terms.txt" > /dev/null || exit 1
+	elapsed=$(($(now_ms) - start))
+	[ -z "$best" ] || [ "$elapsed" -lt "$best" ] && best=$elapsed
+	r=$((r + 1))
+done
+echo "point-free-lambda: $n terms, ${best} ms"
@@ -0,0 +1,128 @@
+#!/bin/sh
+# Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#
+# End to end throughput of point-free over the metafunctions in corpus/,
+# compared with a stored baseline (the point-free-corpus-bench target runs
+# it for the built point-free):
+#
+#   bench/Corpus.sh build/bin/point-free [baseline]
+#
+# Every corpus file is converted with -discover REPEAT times, and
+#
+#   conversions_per_second   conversions over the time of every run
+#   p50_ms, p90_ms, p99_ms   percentiles of the time of each run of a file
+#   peak_rss_kb              the largest resident set of any run, when GNU
+#                            time is installed, otherwise 0
+#
+# are written to stdout. The benchmark fails when conversions_per_second is
+# more than THRESHOLD percent below the baseline's, or peak_rss_kb more than
+# THRESHOLD percent above it, and when a file converts nothing or reports an
+# error. Timings only compare on one machine, so the baseline is recorded
+# on the machine that runs the benchmark, with UPDATE_BASELINE=1, which
+# writes the result as the baseline instead of comparing with it. Without a
+# baseline the benchmark fails, rather than pass with nothing to compare.
+
+PF=${1:-point-free}
+HERE=$(cd "$(dirname "$0")" && pwd)
+BASELINE=${2:-$HERE/corpus/baseline.txt}
+REPEAT=${REPEAT:-5}
+THRESHOLD=${THRESHOLD:-10}
+FLAGS=${FLAGS:--std=c++17}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+now_ms() {
+	echo $(($(date +%s%N) / 1000000))
+}
+
+TIME=
+[ -x /usr/bin/time ] && /usr/bin/time -f %M true > /dev/null 2>&1 && TIME=/usr/bin/time
+
+conversions=0
+total=0
+rss=0
+: > "$WORK/latencies"
+
+r=0
+while [ $r -lt "$REPEAT" ]; do
+	for file in "$HERE"/corpus/*.cpp; do
+		start=$(now_ms)
+		if [ -n "$TIME" ]; then
+			$TIME -f %M -o "$WORK/rss" "$PF" -discover -format=json "$file" -- $FLAGS > "$WORK/out"
+		else
+			"$PF" -discover -format=json "$file" -- $FLAGS > "$WORK/out"
+		fi || { echo "$(basename "$file"): point-free failed"; exit 1; }
+		elapsed=$(($(now_ms) - start))
+
+		if grep -q '"error"' "$WORK/out"; then
+			echo "$(basename "$file"): $(grep '"error"' "$WORK/out" | head -n 1)"
+			exit 1
+		fi
+		converted=$(grep -c '"output"' "$WORK/out")
+		if [ "$converted" -eq 0 ]; then
+			echo "$(basename "$file"): nothing converted"
+			exit 1
+		fi
+
+		conversions=$((conversions + converted))
+		total=$((total + elapsed))
+		echo "$elapsed" >> "$WORK/latencies"
+		if [ -n "$TIME" ]; then
+			kb=$(tail -n 1 "$WORK/rss")
+			[ "$kb" -gt "$rss" ] && rss=$kb
+		fi
+	done
+	r=$((r + 1))
+done
+
+# percentile <p>, nearest rank
+percentile() {
+	n=$(wc -l < "$WORK/latencies")
+	rank=$((($1 * n + 99) / 100))
+	sort -n "$WORK/latencies" | sed -n "${rank}p"
+}
+
+[ "$total" -gt 0 ] || total=1
+cat > "$WORK/result" <<EOF
+conversions_per_second $((conversions * 1000 / total))
+p50_ms $(percentile 50)
+p90_ms $(percentile 90)
+p99_ms $(percentile 99)
+peak_rss_kb $rss
+EOF
+cat "$WORK/result"
+
+if [ "$UPDATE_BASELINE" = 1 ]; then
+	cp "$WORK/result" "$BASELINE" || exit 1
+	echo "Wrote the baseline $BASELINE"
+	exit 0
+fi
+
+if [ ! -f "$BASELINE" ]; then
+	echo "No baseline $BASELINE, record one with UPDATE_BASELINE=1"
+	exit 1
+fi
+
+# value <file> <metric>
+value() {
+	sed -n "s/^$2 //p" "$1"
+}
+
+failed=0
+
+base=$(value "$BASELINE" conversions_per_second)
+now=$(value "$WORK/result" conversions_per_second)
+if [ $((now * 100)) -lt $((base * (100 - THRESHOLD))) ]; then
+	echo "conversions_per_second fell from $base to $now, more than $THRESHOLD%"
+	failed=1
+fi
+
+base=$(value "$BASELINE" peak_rss_kb)
+now=$(value "$WORK/result" peak_rss_kb)
+if [ "$base" -gt 0 ] && [ $((now * 100)) -gt $((base * (100 + THRESHOLD))) ]; then
+	echo "peak_rss_kb rose from $base to $now, more than $THRESHOLD%"
+	failed=1
+fi
+
+[ $failed -eq 0 ] && echo "Within $THRESHOLD% of the baseline $BASELINE"
+exit $failed
@@ -0,0 +1,52 @@
+#!/bin/sh
+# Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#
+# Startup benchmark of the executables, for editors and scripts that start
+# one per conversion. Each is timed RUNS times starting up and exiting
+# (-version), and converting a one line metafunction, the identity, so that
+# what is measured is everything but the conversion:
+#
+#   bench/Startup.sh build/bin
+#
+# The mean of the RUNS runs is reported. point-free-lambda parses no C++,
+# it is the floor for the other two. point-free-lite must print what
+# point-free prints.
+
+BIN=${1:-.}
+RUNS=${RUNS:-20}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+now_ms() {
+	echo $(($(date +%s%N) / 1000000))
+}
+
+# mean_ms <command> ...
+mean_ms() {
+	r=0
+	start=$(now_ms)
+	while [ $r -lt "$RUNS" ]; do
+		"$@" > /dev/null 2>&1 || return 1
+		r=$((r + 1))
+	done
+	echo $((($(now_ms) - start) / RUNS))
+}
+
+echo "template <class T> struct Identity { using type = T; };" > "$WORK/identity.cpp"
+
+full=$("$BIN/point-free" -classname=Identity "$WORK/identity.cpp" --) || exit 1
+lite=$("$BIN/point-free-lite" -classname=Identity "$WORK/identity.cpp" --) || exit 1
+if [ "$full" != "$lite" ]; then
+	echo "point-free-lite printed \"$lite\", point-free printed \"$full\""
+	exit 1
+fi
+
+for tool in point-free point-free-lite point-free-lambda; do
+	startup=$(mean_ms "$BIN/$tool" -version) || { echo "$tool: failed"; exit 1; }
+	if [ "$tool" = point-free-lambda ]; then
+		convert=$(mean_ms "$BIN/$tool" '\x -> x')
+	else
+		convert=$(mean_ms "$BIN/$tool" -classname=Identity "$WORK/identity.cpp" --)
+	fi || { echo "$tool: failed"; exit 1; }
+	echo "$tool: startup ${startup} ms, conversion ${convert} ms"
+done
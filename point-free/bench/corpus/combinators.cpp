@@ -0,0 +1,39 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+// Benchmark corpus, the combinators themselves written pointfully.
+
+template <class...> struct F;
+template <class...> struct G;
+template <class...> struct H;
+
+template <class T>
+struct Identity { using type = T; };
+
+template <class T, class U>
+struct First { using type = T; };
+
+template <class T, class U>
+struct Second { using type = U; };
+
+template <class T, class U, class V>
+struct Flip { using type = F<V, U>; };
+
+template <class T, class U>
+struct Compose { using type = F<G<T, U>>; };
+
+template <class T, class U, class V>
+struct Substitute { using type = F<T, V, G<U, V>>; };
+
+template <class T>
+struct Twice { using type = F<F<T>>; };
+
+template <class T, class U>
+struct Duplicate { using type = G<T, T, U, U>; };
+
+template <class T, class U, class V>
+struct Rotate { using type = H<V, T, U>; };
+
+template <class T, class U, class V>
+struct Spread { using type = F<G<T>, G<U>, G<V>>; };
+
+template <class T, class U, class V, class W>
+struct Nest { using type = F<G<H<T, U>, V>, W>; };
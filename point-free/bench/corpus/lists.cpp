@@ -0,0 +1,50 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+// Benchmark corpus, type list metafunctions with specializations.
+
+template <class...> struct List {};
+template <class...> struct Pair;
+
+template <class L>
+struct Front;
+
+template <class T, class... Ts>
+struct Front<List<T, Ts...>> { using type = T; };
+
+template <class L, class T>
+struct PushFront;
+
+template <class... Ts, class T>
+struct PushFront<List<Ts...>, T> { using type = List<T, Ts...>; };
+
+template <class L, class T>
+struct PushBack;
+
+template <class... Ts, class T>
+struct PushBack<List<Ts...>, T> { using type = List<Ts..., T>; };
+
+template <class T, class U>
+struct MakePair { using type = Pair<T, U>; };
+
+template <class T, class U>
+struct SwapPair { using type = typename MakePair<U, T>::type; };
+
+template <class T, class U, class V>
+struct Triple { using type = List<T, typename MakePair<U, V>::type>; };
+
+template <class L>
+struct Length;
+
+template <>
+struct Length<List<>> { static constexpr int value = 0; };
+
+template <class T, class... Ts>
+struct Length<List<T, Ts...>> { static constexpr int value = 1 + Length<List<Ts...>>::value; };
+
+template <class L>
+struct Reverse;
+
+template <>
+struct Reverse<List<>> { using type = List<>; };
+
+template <class T, class... Ts>
+struct Reverse<List<T, Ts...>> { using type = typename PushBack<typename Reverse<List<Ts...>>::type, T>::type; };
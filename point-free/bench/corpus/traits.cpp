@@ -0,0 +1,31 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+// Benchmark corpus, metafunctions over the standard type traits, so that
+// <type_traits> is parsed as in most real files.
+#include <type_traits>
+
+template <class T>
+struct AddConstRef { using type = typename std::add_lvalue_reference<typename std::add_const<T>::type>::type; };
+
+template <class T>
+struct Decayed { using type = typename std::decay<T>::type; };
+
+template <class T>
+struct PointerTo { using type = T*; };
+
+template <class T>
+struct PointerToPointer { using type = T**; };
+
+template <class T, class U>
+struct Same { static constexpr bool value = std::is_same<T, U>::value; };
+
+template <class B, class T, class U>
+struct Select { using type = typename std::conditional<B::value, T, U>::type; };
+
+template <class T, class U>
+struct Common { using type = typename std::common_type<T, U>::type; };
+
+template <class T>
+struct Unqualified { using type = typename std::remove_cv<typename std::remove_reference<T>::type>::type; };
+
+template <class T, class U>
+struct FirstIfPointer { using type = typename std::conditional<std::is_pointer<T>::value, T, U>::type; };
@@ -0,0 +1,21 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+// Benchmark corpus, metafunctions of many parameters whose results are
+// much larger than their definitions.
+
+template <class...> struct F;
+template <class...> struct G;
+
+template <class A, class B, class C, class D, class E>
+struct Reverse5 { using type = F<E, D, C, B, A>; };
+
+template <class A, class B, class C, class D, class E, class X>
+struct Interleave6 { using type = F<A, X, B, X, C, X, D, X, E>; };
+
+template <class A, class B, class C, class D, class E, class X, class Y>
+struct Nested7 { using type = F<G<A, Y>, G<B, X>, G<C, Y>, G<D, X>, G<E, Y>>; };
+
+template <class A, class B, class C, class D, class E, class X, class Y, class Z>
+struct Cross8 { using type = F<G<Z, A, Y>, G<X, B, Z>, G<Y, C, X>, G<Z, D, Y>, G<X, E, Z>>; };
+
+template <class A, class B, class C, class D>
+struct Square4 { using type = F<G<A, B, C, D>, G<B, C, D, A>, G<C, D, A, B>, G<D, A, B, C>>; };
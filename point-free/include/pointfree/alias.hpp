@@ -0,0 +1,155 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#pragma once
+#include <cstddef>
+#include <type_traits>
+
+////////////////////////////////////////////////////////////////////////
+/* Alias Template Backend Prelude 									  */
+////////////////////////////////////////////////////////////////////////
+
+// What the output of point-free -backend=alias refers to, using nothing but
+// C++17. A result is a class with a fn member alias template taking one
+// argument, apply instantiates it:
+//
+//   using namespace pointfree::alias;
+//   using Second = apply<const_,id>;
+//   static_assert(std::is_same_v<apply<apply<Second,int>,char>, char>);
+//
+// Point-free results partially apply everything, so quote (and quote_trait,
+// for traits with a type member) curry the template they wrap: arguments
+// are collected until the template can be instantiated with them.
+
+namespace pointfree {
+namespace alias {
+
+template <class F, class X>
+using apply = typename F::template fn<X>;
+
+template <template <class...> class F, class... Args>
+struct quote;
+
+template <template <class...> class F, class... Args>
+struct quote_trait;
+
+// Where route passes each of the variables following f and g.
+enum class to { f, g, fg };
+
+namespace detail {
+
+template <class Void, template <class...> class F, class... Args>
+struct valid : std::false_type {};
+
+template <template <class...> class F, class... Args>
+struct valid<std::void_t<F<Args...>>, F, Args...> : std::true_type {};
+
+template <bool Saturated, template <class...> class F, class... Args>
+struct call { using type = quote<F, Args...>; };
+
+template <template <class...> class F, class... Args>
+struct call<true, F, Args...> { using type = F<Args...>; };
+
+template <bool Saturated, template <class...> class F, class... Args>
+struct call_trait { using type = quote_trait<F, Args...>; };
+
+template <template <class...> class F, class... Args>
+struct call_trait<true, F, Args...> { using type = typename F<Args...>::type; };
+
+// Body, taking N arguments, taking them one at a time.
+template <std::size_t N, template <class...> class Body, class... Args>
+struct curried;
+
+template <std::size_t N, template <class...> class Body, class... Args>
+struct next { using type = curried<N, Body, Args...>; };
+
+template <template <class...> class Body, class... Args>
+struct next<0, Body, Args...> { using type = Body<Args...>; };
+
+template <std::size_t N, template <class...> class Body, class... Args>
+struct curried {
+	template <class X>
+	using fn = typename next<N - 1, Body, Args..., X>::type;
+};
+
+template <class F, class G, class X>
+using S = apply<apply<F, X>, apply<G, X>>;
+
+template <class F, class X, class Y>
+using flip = apply<apply<F, Y>, X>;
+
+template <class F, class G, class X>
+using compose = apply<F, apply<G, X>>;
+
+template <class X, class Y>
+using const_ = X;
+
+template <class F, class X>
+using dollar = apply<F, X>;
+
+// fix F is F (fix F), the inner fix F is only expanded when it is applied
+template <class F>
+struct fixed {
+	template <class X>
+	using fn = apply<apply<F, fixed<F>>, X>;
+};
+
+template <class F>
+using fix = apply<F, fixed<F>>;
+
+template <to... Routes>
+struct routes {};
+
+// F and G given the variables routed to them, then F applied to G.
+template <class F, class G, class Routes, class... Xs>
+struct routed;
+
+template <bool Pass, class F, class X>
+struct pass { using type = F; };
+
+template <class F, class X>
+struct pass<true, F, X> { using type = apply<F, X>; };
+
+template <class F, class G>
+struct routed<F, G, routes<>> { using type = apply<F, G>; };
+
+template <class F, class G, to R, to... Rs, class X, class... Xs>
+struct routed<F, G, routes<R, Rs...>, X, Xs...>
+	: routed<typename pass<R != to::g, F, X>::type, typename pass<R != to::f, G, X>::type,
+	         routes<Rs...>, Xs...> {};
+
+template <class Routes>
+struct route_fn {
+	template <class F, class G, class... Xs>
+	using fn = typename routed<F, G, Routes, Xs...>::type;
+};
+
+} // namespace detail
+
+template <template <class...> class F, class... Args>
+struct quote {
+	template <class X>
+	using fn = typename detail::call<detail::valid<void, F, Args..., X>::value, F, Args..., X>::type;
+};
+
+template <template <class...> class F, class... Args>
+struct quote_trait {
+	template <class X>
+	using fn = typename detail::call_trait<detail::valid<void, F, Args..., X>::value, F, Args..., X>::type;
+};
+
+struct id { template <class X> using fn = X; };
+struct const_ : detail::curried<2, detail::const_> {};
+struct S : detail::curried<3, detail::S> {};
+struct flip : detail::curried<3, detail::flip> {};
+struct compose : detail::curried<3, detail::compose> {};
+struct dollar : detail::curried<2, detail::dollar> {};
+struct fix : detail::curried<1, detail::fix> {};
+
+// The routing combinators of point-free -bulk, passing each variable after
+// f and g to f, g or both and then applying f to g:
+//
+//   route<to::f,to::g,to::fg> f g x y z = f x z (g y z)
+template <to... Routes>
+struct route : detail::curried<sizeof...(Routes) + 2, detail::route_fn<detail::routes<Routes...>>::template fn> {};
+
+} // namespace alias
+} // namespace pointfree
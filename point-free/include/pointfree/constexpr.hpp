@@ -0,0 +1,575 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#pragma once
+#include "alias.hpp"
+
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+
+#if __cplusplus < 202002L
+#error "pointfree/constexpr.hpp requires C++20"
+#endif
+
+////////////////////////////////////////////////////////////////////////
+/* Compile-Time Point-Free Algorithm 								  */
+////////////////////////////////////////////////////////////////////////
+
+// The Point-Free algorithm as constant evaluation, for header-only users
+// that would rather not run point-free-lambda as a build step. A term is
+// written as for point-free-lambda (see LambdaParser.h) and converted while
+// the program is compiled, to the alias backend's spelling or straight to a
+// type, its free names bound to types:
+//
+//   using namespace pointfree::alias;
+//   static_assert(pointfree::ct::point_free_string<"\\x y -> f y x"> == "apply<flip,quote<f>>");
+//
+//   template <class, class> struct pair {};
+//   using Swap = pointfree::ct::point_free_t<"\\x y -> f y x", pointfree::ct::bind<"f", quote<pair>>>;
+//   static_assert(std::is_same_v<apply<apply<Swap, int>, char>, pair<char, int>>);
+//
+// The result is the one point-free -backend=alias gives, except that names
+// are not looked up: id, const_, S, flip, compose, dollar and fix are the
+// combinators, '*' (or add_pointer_t) is std::add_pointer_t, a primitive
+// type such as int is written as it is and any other free name is written
+// quote<name>. Parameter packs are not supported.
+//
+// Expressions live in a fixed number of nodes, which, as in ExprPool.h, are
+// never changed once added. Conversion needs more nodes than the term has,
+// the default is enough for terms of a few dozen binders; a term that needs
+// more is rejected and converted<Term, Capacity> takes a larger capacity.
+
+namespace pointfree {
+namespace ct {
+
+template <std::size_t N>
+struct fixed_string {
+	char data[N] = {};
+
+	constexpr fixed_string() = default;
+	constexpr fixed_string(const char (&text)[N]) {
+		for (std::size_t i = 0; i < N; ++i)
+			data[i] = text[i];
+	}
+
+	static constexpr std::size_t size() { return N - 1; }
+	constexpr std::string_view view() const { return std::string_view(data, N - 1); }
+};
+
+enum class kind : unsigned char {
+	free,		// a: offset of the name in the term, b: its length
+	bound,		// a: binder
+	combinator,	// a: the combinator, see combinator_names
+	app,		// a: function, b: argument
+	lambda		// a: binder, b: body
+};
+
+struct node {
+	kind k = kind::free;
+	unsigned a = 0;
+	unsigned b = 0;
+};
+
+inline constexpr std::string_view combinator_names[] = {
+	"id", "const_", "S", "flip", "compose", "dollar", "fix", "add_pointer_t"
+};
+
+enum : unsigned { id_, const__, S_, flip_, compose_, dollar_, fix_, add_pointer_ };
+
+// The primitive types of isAPrimitiveType in Common.cpp that are a single
+// name, which are written as they are rather than quoted.
+inline constexpr std::string_view primitive_names[] = {
+	"short", "int", "signed", "unsigned", "long", "float", "double", "char", "wchar_t",
+	"char16_t", "char32_t", "string", "void", "nullptr_t", "nullptr", "bool", "true", "false"
+};
+
+constexpr bool is_primitive(std::string_view name) {
+	for (std::string_view primitive : primitive_names) {
+		if (primitive == name)
+			return true;
+	}
+	return false;
+}
+
+template <std::size_t Capacity>
+struct term {
+	node nodes[Capacity] = {};
+	unsigned size = 0;
+	unsigned root = 0;
+
+	// set, with the column of the term it refers to, when conversion fails
+	const char* error = nullptr;
+	std::size_t column = 0;
+
+	constexpr unsigned add(node n) {
+		if (size == Capacity) {
+			fail("the term needs more nodes than the capacity", 0);
+			return 0;
+		}
+		nodes[size] = n;
+		return size++;
+	}
+
+	constexpr void fail(const char* message, std::size_t at) {
+		if (error == nullptr) {
+			error = message;
+			column = at + 1;
+		}
+	}
+};
+
+constexpr std::size_t default_capacity(std::size_t length) {
+	return 16 * length + 64;
+}
+
+namespace detail {
+
+constexpr bool is_space(char c) {
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+constexpr bool is_name_char(char c) {
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '\'';
+}
+
+// LambdaParser.cpp, resolving each name as it is read: a bound name refers
+// to its binder, every lambda having a binder of its own, which renames as
+// AlphaRename does. '*' is put first in its application as Shuffle does.
+template <std::size_t Capacity>
+class parser {
+public:
+	constexpr parser(std::string_view text, term<Capacity>& t) : text(text), t(t) {}
+
+	constexpr void parse() {
+		t.root = parse_term();
+		skip_space();
+		if (pos != text.size())
+			t.fail("unexpected character", pos);
+	}
+
+private:
+	static constexpr unsigned max_scope = 64;
+
+	constexpr void skip_space() {
+		while (pos < text.size() && is_space(text[pos]))
+			++pos;
+	}
+
+	constexpr bool peek(char c) {
+		skip_space();
+		return pos < text.size() && text[pos] == c;
+	}
+
+	constexpr bool peek_arrow() {
+		skip_space();
+		return text.substr(pos, 2) == "->";
+	}
+
+	constexpr std::string_view parse_name() {
+		skip_space();
+		std::size_t start = pos;
+
+		if (pos < text.size() && text[pos] == '*')
+			return text.substr(pos++, 1);
+
+		if (text.substr(pos, 3) == "...") {
+			t.fail("parameter packs are not supported", pos);
+			return {};
+		}
+
+		while (pos < text.size()) {
+			if (is_name_char(text[pos]))
+				++pos;
+			else if (text.substr(pos, 2) == "::")
+				pos += 2;
+			else
+				break;
+		}
+
+		if (pos == start || !is_name_char(text[pos - 1])) {
+			pos = start;
+			return {};
+		}
+
+		return text.substr(start, pos - start);
+	}
+
+	constexpr unsigned parse_term() {
+		if (t.error)
+			return 0;
+		if (!peek('\\'))
+			return parse_app();
+
+		++pos;
+		unsigned outer = depth;
+
+		while (!peek_arrow()) {
+			std::size_t at = pos;
+			std::string_view name = parse_name();
+
+			if (name.empty()) {
+				t.fail("expected a parameter name or '->'", at);
+				return 0;
+			}
+			if (depth == max_scope) {
+				t.fail("too many nested parameters", at);
+				return 0;
+			}
+
+			names[depth] = name;
+			binders[depth++] = next_binder++;
+		}
+
+		if (depth == outer) {
+			t.fail("lambda without parameters", pos);
+			return 0;
+		}
+
+		pos += 2;
+		unsigned body = parse_term();
+
+		while (depth > outer) {
+			--depth;
+			body = t.add(node{kind::lambda, binders[depth], body});
+		}
+
+		return body;
+	}
+
+	constexpr unsigned parse_app() {
+		unsigned expr = parse_atom();
+
+		for (;;) {
+			if (t.error)
+				return 0;
+
+			skip_space();
+			if (pos == text.size() || peek(')'))
+				break;
+
+			unsigned arg = peek('\\') ? parse_term() : parse_atom();
+
+			const node& x = t.nodes[arg];
+			if (x.k == kind::combinator && x.a == add_pointer_)
+				expr = t.add(node{kind::app, arg, expr});
+			else
+				expr = t.add(node{kind::app, expr, arg});
+		}
+
+		return expr;
+	}
+
+	constexpr unsigned parse_atom() {
+		if (t.error)
+			return 0;
+
+		if (peek('(')) {
+			++pos;
+			unsigned expr = parse_term();
+
+			if (!t.error && !peek(')'))
+				t.fail("expected ')'", pos);
+
+			++pos;
+			return expr;
+		}
+
+		std::size_t at = pos;
+		std::string_view name = parse_name();
+
+		if (name.empty()) {
+			t.fail(pos < text.size() ? "unexpected character" : "unexpected end of term", at);
+			return 0;
+		}
+
+		return resolve(name);
+	}
+
+	constexpr unsigned resolve(std::string_view name) {
+		for (unsigned i = depth; i > 0; --i) {
+			if (names[i - 1] == name)
+				return t.add(node{kind::bound, binders[i - 1], 0});
+		}
+
+		if (name == "*")
+			return t.add(node{kind::combinator, add_pointer_, 0});
+
+		for (unsigned c = 0; c < sizeof(combinator_names) / sizeof(combinator_names[0]); ++c) {
+			if (combinator_names[c] == name)
+				return t.add(node{kind::combinator, c, 0});
+		}
+
+		std::size_t offset = static_cast<std::size_t>(name.data() - text.data());
+		return t.add(node{kind::free, static_cast<unsigned>(offset), static_cast<unsigned>(name.size())});
+	}
+
+	std::string_view text;
+	term<Capacity>& t;
+	std::size_t pos = 0;
+
+	std::string_view names[max_scope] = {};
+	unsigned binders[max_scope] = {};
+	unsigned depth = 0;
+	unsigned next_binder = 0;
+};
+
+// RemoveVariable and TransformRecursive from Common.cpp, case for case.
+template <std::size_t Capacity>
+constexpr bool free_in(const term<Capacity>& t, unsigned binder, unsigned n) {
+	const node& x = t.nodes[n];
+
+	switch (x.k) {
+	case kind::bound:
+		return x.a == binder;
+	case kind::app:
+		return free_in(t, binder, x.a) || free_in(t, binder, x.b);
+	case kind::lambda:
+		return x.a != binder && free_in(t, binder, x.b);
+	default:
+		return false;
+	}
+}
+
+template <std::size_t Capacity>
+constexpr unsigned transform(term<Capacity>& t, unsigned n);
+
+template <std::size_t Capacity>
+constexpr unsigned remove_variable(term<Capacity>& t, unsigned binder, unsigned n) {
+	if (t.error)
+		return 0;
+
+	const node x = t.nodes[n];
+
+	switch (x.k) {
+	case kind::lambda:
+		return remove_variable(t, binder, transform(t, n));
+
+	case kind::app: {
+		bool frL = free_in(t, binder, x.a);
+		bool frR = free_in(t, binder, x.b);
+		const node& right = t.nodes[x.b];
+
+		if (frL && frR) {
+			unsigned l = remove_variable(t, binder, x.a);
+			unsigned r = remove_variable(t, binder, x.b);
+			unsigned s = t.add(node{kind::combinator, S_, 0});
+			return t.add(node{kind::app, t.add(node{kind::app, s, l}), r});
+		} else if (frL) {
+			unsigned l = remove_variable(t, binder, x.a);
+			unsigned flip = t.add(node{kind::combinator, flip_, 0});
+			return t.add(node{kind::app, t.add(node{kind::app, flip, l}), x.b});
+		} else if (right.k == kind::bound && right.a == binder) {
+			return x.a;
+		} else if (frR) {
+			unsigned r = remove_variable(t, binder, x.b);
+			unsigned compose = t.add(node{kind::combinator, compose_, 0});
+			return t.add(node{kind::app, t.add(node{kind::app, compose, x.a}), r});
+		}
+		break;
+	}
+
+	case kind::bound:
+		if (x.a == binder)
+			return t.add(node{kind::combinator, id_, 0});
+		break;
+
+	default:
+		break;
+	}
+
+	unsigned k = t.add(node{kind::combinator, const__, 0});
+	return t.add(node{kind::app, k, n});
+}
+
+template <std::size_t Capacity>
+constexpr unsigned transform(term<Capacity>& t, unsigned n) {
+	if (t.error)
+		return 0;
+
+	const node x = t.nodes[n];
+
+	if (x.k == kind::app) {
+		unsigned l = transform(t, x.a);
+		unsigned r = transform(t, x.b);
+		if (l == x.a && r == x.b)
+			return n;
+		return t.add(node{kind::app, l, r});
+	}
+
+	if (x.k == kind::lambda)
+		return transform(t, remove_variable(t, x.a, x.b));
+
+	return n;
+}
+
+// Writes the alias backend's spelling of a converted term to out, or only
+// counts its length when out is nullptr.
+template <std::size_t Capacity>
+struct writer {
+	const term<Capacity>& t;
+	std::string_view text;
+	char* out = nullptr;
+	std::size_t size = 0;
+
+	constexpr void put(std::string_view s) {
+		for (char c : s) {
+			if (out)
+				out[size] = c;
+			++size;
+		}
+	}
+
+	constexpr void write(unsigned n) {
+		const node& x = t.nodes[n];
+
+		switch (x.k) {
+		case kind::free:
+			if (is_primitive(text.substr(x.a, x.b))) {
+				put(text.substr(x.a, x.b));
+				break;
+			}
+			put("quote<");
+			put(text.substr(x.a, x.b));
+			put(">");
+			break;
+		case kind::combinator:
+			put(x.a == add_pointer_ ? "quote<std::add_pointer_t>" : combinator_names[x.a]);
+			break;
+		case kind::app:
+			put("apply<");
+			write(x.a);
+			put(",");
+			write(x.b);
+			put(">");
+			break;
+		default:
+			// only reached for a term that failed to convert
+			break;
+		}
+	}
+};
+
+} // namespace detail
+
+// Parses and converts text, leaving error set if it can't.
+template <std::size_t Capacity>
+constexpr term<Capacity> convert(std::string_view text) {
+	term<Capacity> t;
+	detail::parser<Capacity>(text, t).parse();
+	t.root = detail::transform(t, t.root);
+	return t;
+}
+
+template <fixed_string Term, std::size_t Capacity = default_capacity(Term.size())>
+struct converted {
+	static constexpr auto source = Term;
+	static constexpr term<Capacity> result = convert<Capacity>(Term.view());
+	static_assert(result.error == nullptr, "the term could not be converted, see converted<>::result.error");
+
+private:
+	static constexpr std::size_t length() {
+		detail::writer<Capacity> w{result, source.view()};
+		w.write(result.root);
+		return w.size;
+	}
+
+	static constexpr fixed_string<length() + 1> spell() {
+		fixed_string<length() + 1> s;
+		detail::writer<Capacity> w{result, source.view(), s.data};
+		w.write(result.root);
+		return s;
+	}
+
+public:
+	static constexpr fixed_string<length() + 1> text = spell();
+};
+
+template <fixed_string Term>
+inline constexpr std::string_view point_free_string = converted<Term>::text.view();
+
+// Binds a free name of a term to a type, for point_free_t.
+template <fixed_string Name, class T>
+struct bind {
+	static constexpr auto name = Name;
+	using type = T;
+};
+
+namespace detail {
+
+template <class T>
+inline constexpr bool always_false = false;
+
+template <class Converted, unsigned N, kind K, class... Bindings>
+struct build;
+
+template <class Converted, unsigned N, class... Bindings>
+using build_t = typename build<Converted, N, Converted::result.nodes[N].k, Bindings...>::type;
+
+template <unsigned Combinator>
+struct combinator_type;
+
+template <> struct combinator_type<id_> { using type = alias::id; };
+template <> struct combinator_type<const__> { using type = alias::const_; };
+template <> struct combinator_type<S_> { using type = alias::S; };
+template <> struct combinator_type<flip_> { using type = alias::flip; };
+template <> struct combinator_type<compose_> { using type = alias::compose; };
+template <> struct combinator_type<dollar_> { using type = alias::dollar; };
+template <> struct combinator_type<fix_> { using type = alias::fix; };
+template <> struct combinator_type<add_pointer_> { using type = alias::quote<std::add_pointer_t>; };
+
+template <class Converted, unsigned N, class... Bindings>
+struct build<Converted, N, kind::combinator, Bindings...>
+	: combinator_type<Converted::result.nodes[N].a> {};
+
+template <class Converted, unsigned N, class... Bindings>
+struct build<Converted, N, kind::app, Bindings...> {
+	using type = alias::apply<build_t<Converted, Converted::result.nodes[N].a, Bindings...>,
+	                          build_t<Converted, Converted::result.nodes[N].b, Bindings...>>;
+};
+
+template <class Converted, unsigned N, class... Bindings>
+struct lookup {
+	static constexpr std::size_t find() {
+		constexpr node x = Converted::result.nodes[N];
+		constexpr std::string_view name = Converted::source.view().substr(x.a, x.b);
+		std::string_view names[] = { Bindings::name.view()..., std::string_view() };
+
+		for (std::size_t i = 0; i < sizeof...(Bindings); ++i) {
+			if (names[i] == name)
+				return i;
+		}
+		return sizeof...(Bindings);
+	}
+
+	static constexpr std::size_t index = find();
+};
+
+template <std::size_t I, class... Bindings>
+struct nth;
+
+template <class B, class... Bindings>
+struct nth<0, B, Bindings...> { using type = typename B::type; };
+
+template <std::size_t I, class B, class... Bindings>
+struct nth<I, B, Bindings...> : nth<I - 1, Bindings...> {};
+
+template <std::size_t I>
+struct nth<I> {
+	static_assert(always_false<nth>, "a free name of the term has no binding");
+	using type = void;
+};
+
+template <class Converted, unsigned N, class... Bindings>
+struct build<Converted, N, kind::free, Bindings...>
+	: nth<lookup<Converted, N, Bindings...>::index, Bindings...> {};
+
+} // namespace detail
+
+// The converted term as a type of the alias backend, see alias.hpp.
+template <class Converted, class... Bindings>
+using to_type_t = detail::build_t<Converted, Converted::result.root, Bindings...>;
+
+template <fixed_string Term, class... Bindings>
+using point_free_t = to_type_t<converted<Term>, Bindings...>;
+
+} // namespace ct
+} // namespace pointfree
@@ -0,0 +1,124 @@
+// Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#pragma once
+#include <boost/mp11/integral.hpp>
+#include <boost/mp11/utility.hpp>
+
+#include <cstddef>
+
+////////////////////////////////////////////////////////////////////////
+/* Boost.Mp11 Backend Prelude 										  */
+////////////////////////////////////////////////////////////////////////
+
+// What the output of point-free -backend=mp11 refers to. A result is a
+// Boost.Mp11 quoted metafunction, applied one argument at a time:
+//
+//   using namespace pointfree::mp11;
+//   using Second = mp_invoke_q<const_,id>;
+//   static_assert(std::is_same<mp_invoke_q<mp_invoke_q<Second,int>,char>, char>::value, "");
+//
+// Point-free results partially apply everything, so quote (and quote_trait,
+// for traits with a type member) curry the template they wrap: arguments
+// are collected until the template can be instantiated with them.
+
+namespace pointfree {
+namespace mp11 {
+
+using boost::mp11::mp_invoke_q;
+
+template <template <class...> class F, class... Args>
+struct quote {
+	template <class X>
+	using fn = boost::mp11::mp_eval_or<quote<F, Args..., X>, F, Args..., X>;
+};
+
+template <template <class...> class F, class... Args>
+struct quote_trait {
+	template <class X>
+	using fn = boost::mp11::mp_eval_or<quote_trait<F, Args..., X>,
+	                                   boost::mp11::mp_quote_trait<F>::template fn, Args..., X>;
+};
+
+// Where route passes each of the variables following f and g.
+enum class to { f, g, fg };
+
+namespace detail {
+
+// Q, a quoted metafunction taking N arguments, taking them one at a time.
+template <std::size_t N, class Q, class... Args>
+struct curried {
+	template <class X>
+	using fn = boost::mp11::mp_eval_if_q<boost::mp11::mp_bool<(N > 1)>,
+	                                     curried<N - 1, Q, Args..., X>, Q, Args..., X>;
+};
+
+template <class F, class G, class X>
+using S = mp_invoke_q<mp_invoke_q<F, X>, mp_invoke_q<G, X>>;
+
+template <class F, class X, class Y>
+using flip = mp_invoke_q<mp_invoke_q<F, Y>, X>;
+
+template <class F, class G, class X>
+using compose = mp_invoke_q<F, mp_invoke_q<G, X>>;
+
+template <class X, class Y>
+using const_ = X;
+
+template <class F, class X>
+using dollar = mp_invoke_q<F, X>;
+
+// fix F is F (fix F), the inner fix F is only expanded when it is applied
+template <class F>
+struct fixed {
+	template <class X>
+	using fn = mp_invoke_q<mp_invoke_q<F, fixed<F>>, X>;
+};
+
+template <class F>
+using fix = mp_invoke_q<F, fixed<F>>;
+
+template <to... Routes>
+struct routes {};
+
+// F and G given the variables routed to them, then F applied to G.
+template <class F, class G, class Routes, class... Xs>
+struct routed;
+
+template <bool Pass, class F, class X>
+struct pass { using type = F; };
+
+template <class F, class X>
+struct pass<true, F, X> { using type = mp_invoke_q<F, X>; };
+
+template <class F, class G>
+struct routed<F, G, routes<>> { using type = mp_invoke_q<F, G>; };
+
+template <class F, class G, to R, to... Rs, class X, class... Xs>
+struct routed<F, G, routes<R, Rs...>, X, Xs...>
+	: routed<typename pass<R != to::g, F, X>::type, typename pass<R != to::f, G, X>::type,
+	         routes<Rs...>, Xs...> {};
+
+template <class Routes>
+struct route_fn {
+	template <class F, class G, class... Xs>
+	using fn = typename routed<F, G, Routes, Xs...>::type;
+};
+
+} // namespace detail
+
+struct id { template <class X> using fn = X; };
+struct const_ : detail::curried<2, boost::mp11::mp_quote<detail::const_>> {};
+struct S : detail::curried<3, boost::mp11::mp_quote<detail::S>> {};
+struct flip : detail::curried<3, boost::mp11::mp_quote<detail::flip>> {};
+struct compose : detail::curried<3, boost::mp11::mp_quote<detail::compose>> {};
+struct dollar : detail::curried<2, boost::mp11::mp_quote<detail::dollar>> {};
+struct fix : detail::curried<1, boost::mp11::mp_quote<detail::fix>> {};
+
+// The routing combinators of point-free -bulk, passing each variable after
+// f and g to f, g or both and then applying f to g:
+//
+//   route<to::f,to::g,to::fg> f g x y z = f x z (g y z)
+template <to... Routes>
+struct route : detail::curried<sizeof...(Routes) + 2, detail::route_fn<detail::routes<Routes...>>> {};
+
+} // namespace mp11
+} // namespace pointfree
@@ -0,0 +1,66 @@
+#!/bin/sh
+# Copyright (c) 2018 Andrew Gozillon & Paul Keir, University of the West of Scotland.
+#
+# End to end checks of the built executables against the sources in
+# inputs/ (the point-free-test target runs them for the build):
+#
+#   test/Run.sh build/bin
+#
+# Each check runs a command and compares what it prints, stdout and stderr
+# together, with what is expected. The failures are listed and the exit
+# status is the number of them.
+
+BIN=${1:-.}
+HERE=$(cd "$(dirname "$0")" && pwd)
+INPUTS=$HERE/inputs
+FLAGS=${FLAGS:--std=c++14}
+failed=0
+
+# check <name> <expected output> <command> ...
+check() {
+	name=$1
+	expected=$2
+	shift 2
+	actual=$("$@" 2>&1)
+	if [ "$actual" != "$expected" ]; then
+		echo "FAIL $name"
+		echo "  expected: $expected"
+		echo "  actual:   $actual"
+		failed=$((failed + 1))
+	else
+		echo "ok   $name"
+	fi
+}
+
+# Same-named templates in different namespaces are all converted. The
+# member is named so point-free doesn't note that it assumed it.
+check "same name in two namespaces" "id
+const_" \
+	"$BIN/point-free" -classname=Foo -membername=type "$INPUTS/namespaces.cpp" -- $FLAGS
+
+check "same name in two namespaces, lite" "id
+const_" \
+	"$BIN/point-free-lite" -classname=Foo "$INPUTS/namespaces.cpp" -- $FLAGS
+
+# -cursor converts the class template at a position, and says why when
+# there is none. ReportError ends its messages with a space.
+CURSOR=$INPUTS/cursor.cpp
+
+check "cursor in a member" "const_" \
+	"$BIN/point-free" -cursor="$CURSOR:3:44" -- $FLAGS
+
+check "cursor outside any class template" "No class template at $CURSOR:5:5 " \
+	"$BIN/point-free" -cursor="$CURSOR:5:5" -- $FLAGS
+
+check "cursor past the end of the file" "Line 40 is past the end of $CURSOR " \
+	"$BIN/point-free" -cursor="$CURSOR:40:1" -- $FLAGS
+
+check "cursor past the end of a line" "Column 70 is past the end of line 3 of $CURSOR " \
+	"$BIN/point-free" -cursor="$CURSOR:3:70" -- $FLAGS
+
+# Flags that only make sense together are rejected rather than ignored.
+check "-run-verification without -emit-verification" \
+	"-run-verification compiles the -emit-verification unit, give -emit-verification=<file> too " \
+	"$BIN/point-free" -classname=Foo -run-verification "$INPUTS/namespaces.cpp" -- $FLAGS
+
+exit $failed
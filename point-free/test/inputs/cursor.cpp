@@ -0,0 +1,5 @@
+// The -cursor checks in Run.sh refer to positions in this file.
+
+template <class T, class U> struct First { using type = T; };
+
+int notATemplate;
@@ -0,0 +1,8 @@
+// Two class templates named Foo, both converted by -classname=Foo.
+namespace ns1 {
+template <class T> struct Foo { using type = T; };
+}
+
+namespace ns2 {
+template <class T, class U> struct Foo { using type = T; };
+}